@@ -0,0 +1,52 @@
+// Times the evaluation kernels of every WASM build that has been built (make wasm-all in src/wasm/build)
+// Each build solves the same instances with the same seed, so objectives must match across builds
+// and the times compare the scalar and SIMD128 kernels directly. Instances come from the bundle (make bundle).
+//
+//   node src/js/bench/kernels.bench.js [pmed numbers...]
+const fs = require('fs');
+const path = require('path');
+const {DEFAULT_BUILD_DIR} = require('../loadCDFLM.js');
+const {InstanceBundle} = require('../loadInstance.js');
+
+const BUILDS = ['cdflm.js', 'cdflm-simd.js'];
+const INSTANCES = process.argv.length > 2 ? process.argv.slice(2).map(Number) : [1, 15, 30, 40];
+const ITERATIONS = 100;
+const SEED = 42;
+
+const bundle = new InstanceBundle();
+
+function benchBuild(createModule) {
+  return Promise.all([createModule(), Promise.all(INSTANCES.map(num => bundle.fetchBytes('pmed' + num)))]).then(([Module, instances]) => {
+    const rows = INSTANCES.map((num, i) => {
+      const problem = Module.loadInstance(instances[i]);
+      const ndpso = new Module.NDPSO(ITERATIONS);
+      ndpso.setSeed(SEED);
+      const results = ndpso.optimize(problem);
+      const row = {instance: 'pmed' + num, kernel: Module.getKernelName(), objective: results.objective, seconds: results.time};
+      results.delete();
+      ndpso.delete();
+      problem.delete();
+      return row;
+    });
+    return rows;
+  });
+}
+
+const available = BUILDS.filter(name => fs.existsSync(path.join(DEFAULT_BUILD_DIR, name)));
+if (!available.length) {
+  console.error('No WASM builds found in ' + DEFAULT_BUILD_DIR + '; run make wasm wasm-simd there first.');
+  process.exit(1);
+}
+
+available.reduce((done, name) => done.then(all => {
+  return benchBuild(require(path.join(DEFAULT_BUILD_DIR, name))).then(rows => all.concat(rows));
+}), Promise.resolve([])).then(rows => {
+  console.table(rows);
+  INSTANCES.forEach(num => {
+    const matching = rows.filter(row => row.instance === 'pmed' + num);
+    if (matching.length === 2) {
+      console.log('pmed' + num + ': ' + (matching[0].seconds / matching[1].seconds).toFixed(2) + 'x with SIMD128' +
+                  (matching[0].objective === matching[1].objective ? '' : ' (OBJECTIVES DIFFER!)'));
+    }
+  });
+});
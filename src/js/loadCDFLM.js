@@ -0,0 +1,57 @@
+const path = require('path');
+
+const SINGLE_THREADED_BUILD = 'cdflm.js';
+const MULTI_THREADED_BUILD = 'cdflm-mt.js';
+const DEFAULT_BUILD_DIR = path.resolve(__dirname, '../wasm/build');
+
+// smallest module that only validates on engines with WebAssembly SIMD: (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt)
+const SIMD_PROBE = [0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11];
+
+// The pthreads build needs SharedArrayBuffer, which browsers only hand out to cross-origin isolated pages.
+// Node has no notion of cross-origin isolation and always supports it.
+function supportsThreads(env) {
+  if (typeof env.SharedArrayBuffer === 'undefined') {
+    return false;
+  }
+  if (typeof env.crossOriginIsolated === 'undefined') {
+    return true;
+  }
+  return env.crossOriginIsolated === true;
+}
+
+function supportsSimd(env) {
+  if (typeof env.WebAssembly === 'undefined') {
+    return false;
+  }
+  return env.WebAssembly.validate(new Uint8Array(SIMD_PROBE));
+}
+
+// cdflm.js, cdflm-mt.js, cdflm-simd.js or cdflm-mt-simd.js
+function chooseBuild(env) {
+  const build = supportsThreads(env) ? MULTI_THREADED_BUILD : SINGLE_THREADED_BUILD;
+  return supportsSimd(env) ? build.replace('.js', '-simd.js') : build;
+}
+
+function defaultThreadCount(env) {
+  if (env.navigator && env.navigator.hardwareConcurrency) {
+    return env.navigator.hardwareConcurrency;
+  }
+  return require('os').cpus().length;
+}
+
+// Loads the best CDFLM module the environment supports and resolves to the instantiated Module.
+// options.load(buildName) returns the module factory; by default it's required from src/wasm/build.
+// options.threads caps the worker pool of the pthreads build (defaults to every core).
+function loadCDFLM(options = {}) {
+  const env = options.env || global;
+  const build = chooseBuild(env);
+  const load = options.load || (name => require(path.join(DEFAULT_BUILD_DIR, name)));
+  return load(build)().then(Module => {
+    if (supportsThreads(env)) {
+      Module.setNumThreads(options.threads || defaultThreadCount(env));
+    }
+    return Module;
+  });
+}
+
+module.exports = {loadCDFLM, chooseBuild, supportsThreads, supportsSimd, SINGLE_THREADED_BUILD, MULTI_THREADED_BUILD, DEFAULT_BUILD_DIR};
@@ -0,0 +1,71 @@
+const fs = require('fs');
+const path = require('path');
+const {DEFAULT_BUILD_DIR} = require('./loadCDFLM.js');
+
+// Fetches single instances out of the precomputed bundle built by `make bundle` in src/wasm/build:
+// problems.json maps an instance name to its byte range in problems.bin, so only that range is downloaded
+// (an HTTP Range request in the browser, a positioned read under Node) and it arrives with its cost matrix already computed.
+class InstanceBundle {
+  // options.baseUrl: where problems.json/problems.bin are served from (browser)
+  // options.dir: directory holding them on disk (Node; defaults to src/wasm/build)
+  // options.readRange(start, length) / options.readIndex(): override how bytes are fetched
+  constructor(options = {}) {
+    const useFiles = options.dir || typeof fetch === 'undefined' || !options.baseUrl;
+    this.readRange = options.readRange || (useFiles ? fileRangeReader(options.dir || DEFAULT_BUILD_DIR) : httpRangeReader(options.baseUrl));
+    this.readIndex = options.readIndex || (useFiles ? fileIndexReader(options.dir || DEFAULT_BUILD_DIR) : httpIndexReader(options.baseUrl));
+    this.index = null;
+  }
+
+  getIndex() {
+    if (!this.index) {
+      this.index = Promise.resolve(this.readIndex()).then(index => index.instances);
+    }
+    return this.index;
+  }
+
+  names() {
+    return this.getIndex().then(instances => Object.keys(instances));
+  }
+
+  // resolves to the raw instance bytes (a Uint8Array)
+  fetchBytes(name) {
+    return this.getIndex().then(instances => {
+      const entry = instances[name];
+      if (!entry) {
+        throw new Error('Unknown instance: ' + name);
+      }
+      return this.readRange(entry.offset, entry.length);
+    });
+  }
+
+  // resolves to a Module.ProblemData handle; delete() it when done
+  load(Module, name) {
+    return this.fetchBytes(name).then(bytes => Module.loadInstance(bytes));
+  }
+}
+
+function httpIndexReader(baseUrl) {
+  return () => fetch(baseUrl + '/problems.json').then(res => res.json());
+}
+
+function httpRangeReader(baseUrl) {
+  return (start, length) => fetch(baseUrl + '/problems.bin', {headers: {Range: 'bytes=' + start + '-' + (start + length - 1)}})
+    .then(res => res.arrayBuffer())
+    .then(buffer => new Uint8Array(buffer));
+}
+
+function fileIndexReader(dir) {
+  return () => JSON.parse(fs.readFileSync(path.join(dir, 'problems.json'), 'utf8'));
+}
+
+function fileRangeReader(dir) {
+  return (start, length) => {
+    const bytes = new Uint8Array(length);
+    const fd = fs.openSync(path.join(dir, 'problems.bin'), 'r');
+    fs.readSync(fd, bytes, 0, length, start);
+    fs.closeSync(fd);
+    return bytes;
+  };
+}
+
+module.exports = {InstanceBundle};
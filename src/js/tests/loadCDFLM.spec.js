@@ -0,0 +1,69 @@
+const fs = require('fs');
+const path = require('path');
+const test = require('tape');
+const {loadCDFLM, chooseBuild, supportsThreads, supportsSimd, SINGLE_THREADED_BUILD, MULTI_THREADED_BUILD, DEFAULT_BUILD_DIR} = require('../loadCDFLM.js');
+const {InstanceBundle} = require('../loadInstance.js');
+
+const hasThreadedBuild = fs.existsSync(path.join(DEFAULT_BUILD_DIR, chooseBuild(global))) &&
+                         fs.existsSync(path.join(DEFAULT_BUILD_DIR, 'problems.bin'));
+
+test('uses the threaded build under node', function(t) {
+  t.true(supportsThreads({SharedArrayBuffer}));
+  t.equal(chooseBuild({SharedArrayBuffer}), MULTI_THREADED_BUILD);
+  t.end();
+});
+
+test('uses the threaded build on cross-origin isolated pages', function(t) {
+  t.equal(chooseBuild({SharedArrayBuffer, crossOriginIsolated: true}), MULTI_THREADED_BUILD);
+  t.end();
+});
+
+test('falls back to the single-threaded build without cross-origin isolation', function(t) {
+  t.equal(chooseBuild({SharedArrayBuffer, crossOriginIsolated: false}), SINGLE_THREADED_BUILD);
+  t.equal(chooseBuild({crossOriginIsolated: false}), SINGLE_THREADED_BUILD);
+  t.equal(chooseBuild({}), SINGLE_THREADED_BUILD);
+  t.end();
+});
+
+test('picks the SIMD variant only when the engine validates SIMD', function(t) {
+  const withSimd = {WebAssembly: {validate: () => true}};
+  const withoutSimd = {WebAssembly: {validate: () => false}};
+  t.equal(chooseBuild(withSimd), 'cdflm-simd.js');
+  t.equal(chooseBuild(Object.assign({SharedArrayBuffer}, withSimd)), 'cdflm-mt-simd.js');
+  t.equal(chooseBuild(withoutSimd), SINGLE_THREADED_BUILD);
+  t.equal(supportsSimd({}), false);
+  t.end();
+});
+
+test('only sizes the worker pool of the threaded build', function(t) {
+  const Module = {setNumThreads: n => { Module.threads = n; }};
+  loadCDFLM({env: {}, load: () => () => Promise.resolve(Module)})
+    .then(() => {
+      t.equal(Module.threads, undefined);
+      return loadCDFLM({env: {SharedArrayBuffer}, threads: 3, load: () => () => Promise.resolve(Module)});
+    })
+    .then(() => {
+      t.equal(Module.threads, 3);
+      t.end();
+    });
+});
+
+test('threaded build solves the same as a single thread', {skip: !hasThreadedBuild}, function(t) {
+  loadCDFLM({threads: 4}).then(Module => {
+    return new InstanceBundle().load(Module, 'pmed1').then(problem => [Module, problem]);
+  }).then(([Module, problem]) => {
+    const objectives = [1, 4].map(threads => {
+      Module.setNumThreads(threads);
+      const ndpso = new Module.NDPSO(50);
+      ndpso.setSeed(42);
+      const results = ndpso.optimize(problem);
+      const objective = results.objective;
+      results.delete();
+      ndpso.delete();
+      return objective;
+    });
+    t.equal(objectives[0], objectives[1]);
+    problem.delete();
+    t.end();
+  });
+});
@@ -0,0 +1,50 @@
+const test = require('tape');
+const {InstanceBundle} = require('../loadInstance.js');
+
+const INDEX = {version: 1, instances: {pmed1: {offset: 0, length: 3}, pmed2: {offset: 3, length: 2}}};
+const BLOB = Uint8Array.from([1, 2, 3, 4, 5]);
+
+function fakeBundle(reads) {
+  return new InstanceBundle({
+    readIndex: () => { reads.index = (reads.index || 0) + 1; return INDEX; },
+    readRange: (start, length) => Promise.resolve(BLOB.slice(start, start + length))
+  });
+}
+
+test('fetchBytes() reads only the byte range of the requested instance', function(t) {
+  const bundle = fakeBundle({});
+  Promise.all([bundle.fetchBytes('pmed1'), bundle.fetchBytes('pmed2')]).then(([first, second]) => {
+    t.looseEqual(Array.from(first), [1, 2, 3]);
+    t.looseEqual(Array.from(second), [4, 5]);
+    t.end();
+  });
+});
+
+test('the index is read once and shared by every load', function(t) {
+  const reads = {};
+  const bundle = fakeBundle(reads);
+  bundle.names()
+    .then(names => {
+      t.looseEqual(names, ['pmed1', 'pmed2']);
+      return bundle.fetchBytes('pmed2');
+    })
+    .then(() => {
+      t.equal(reads.index, 1);
+      t.end();
+    });
+});
+
+test('load() hands the instance bytes to Module.loadInstance', function(t) {
+  const Module = {loadInstance: bytes => ({bytes})};
+  fakeBundle({}).load(Module, 'pmed2').then(problem => {
+    t.looseEqual(Array.from(problem.bytes), [4, 5]);
+    t.end();
+  });
+});
+
+test('unknown instances are rejected', function(t) {
+  fakeBundle({}).fetchBytes('pmed99').catch(err => {
+    t.true(/pmed99/.test(err.message));
+    t.end();
+  });
+});
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <cmath>
+#include <chrono>
 #include <vector>
 #include <cstdlib>
 #include "NDPSO.h"
@@ -19,7 +20,7 @@ using namespace std;
  * @preconditions: none
  * @postconditions: promises that all parameters EXCEPT temperature will be set
  *                      because temperature requires an initial solution to calculate,
- *                      we'll calculate it at the start of ALNS::optimize()
+ *                      we'll calculate it at the start of ALNS::setup()
  **/
 ALNS::ALNS() {
     this->maxIterations  = ALNS_MAX_ITERS;
@@ -44,12 +45,7 @@ ALNS::ALNS() {
  *                  Does NOT delete the Listener! That is the responsibility of the main program!
  **/
 ALNS::~ALNS() {
-    for (auto &pair : this->destroyFuncs) {
-        delete pair.first;
-    }
-    for (auto &pair : this->repairFuncs) {
-        delete pair.first;
-    }
+    this->clearFuncs();
 }
 
 string ALNS::getJSONParameters() {
@@ -62,56 +58,183 @@ string ALNS::getJSONParameters() {
     json += ", newBestReward: "    + to_string(this->getNewBestReward());
     json += ", acceptedBetterReward: "    + to_string(this->getAcceptedBetterReward());
     json += ", acceptedWorseReward: "    + to_string(this->getAcceptedWorseReward());
+    json += ", initStrategy: "    + to_string(this->initStrategy);
+    json += ", weightScheme: "    + to_string(this->weightScheme);
     json += "}";
     return json;
 }
 
 /**
  * Initializes destroyFuncs && repairFuncs to default settings
- * Also sets repairFitnessSum and destroyFitnessSum
  **/
 void ALNS::initDefaultFuncs() {
-    // destroy functions
-    this->destroyFuncs[new FacRandQDestroy(1)]  = 1.0;
-    this->destroyFuncs[new FacBestQDestroy(1)]  = 1.0;
-    this->destroyFuncs[new FacWorstQDestroy(1)] = 1.0;
-    this->destroyFitnessSum = 3.0;
+    // destroy functions, each at every size
+    for (float fraction : DESTROY_FRACTIONS) {
+        this->addScaledDestroyFunc("FacRandQDestroy", fraction);
+        this->addScaledDestroyFunc("FacBestQDestroy", fraction);
+        this->addScaledDestroyFunc("FacWorstQDestroy", fraction);
+    }
 
     // repair functions
-    this->repairFuncs[new FacRandRepair()] = 1.0;
-    this->repairFuncs[new FacLSRepair()]   = 1.0;
-    this->repairFitnessSum = 2.0;
+    this->addRepairFunc(new FacRandRepair());
+    this->addRepairFunc(new FacLSRepair());
+}
+
+/**
+ * Registers a destroy function with a fitness of 1.0
+ * Functions are selected (and checkpointed) in the order they were added, so a fixed seed reproduces a run
+ *
+ * @param ALNSFunction* func: ALNS takes ownership of it
+ * @return void
+ **/
+void ALNS::addDestroyFunc(ALNSFunction* func) {
+    func->setRandom(&this->rng);    // every function draws from this run's generator
+    this->destroyFuncs.push_back({ func, 1.0 });
+    this->buildTable(this->destroyTable, this->destroyFuncs);
+}
+
+void ALNS::addRepairFunc(ALNSFunction* func) {
+    func->setRandom(&this->rng);
+    this->repairFuncs.push_back({ func, 1.0 });
+    this->buildTable(this->repairTable, this->repairFuncs);
+}
+
+/**
+ * Registers a destroy function by name
+ *
+ * @param const string& name: e.g. "FacRandQDestroy"
+ * @param int q: number of facilities it destroys, at least 1 (a problem with fewer facilities loses all of them)
+ * @return void
+ **/
+void ALNS::addDestroyFunc(const string& name, int q) {
+    if (q < 1) throw "ALNS::addDestroyFunc(): a destroy function must destroy at least one facility!";
+    ALNSFunction* func = makeDestroyFunc(name, q);
+    if (func == nullptr) throw "ALNS::addDestroyFunc(): unknown destroy function!";
+    this->addDestroyFunc(func);
+}
+
+/**
+ * Registers a destroy function by name whose size follows p: it destroys round(fraction * p) facilities, at least 1
+ * (resolved whenever a search is set up, see scaleFuncs())
+ *
+ * @param const string& name
+ * @param float fraction: of p, in (0, 1]; 0 destroys a single facility
+ * @return void
+ **/
+void ALNS::addScaledDestroyFunc(const string& name, float fraction) {
+    ALNSFunction* func = makeDestroyFunc(name, 1);
+    if (func == nullptr) throw "ALNS::addScaledDestroyFunc(): unknown destroy function!";
+    func->setFractionToChange(fraction);
+    this->addDestroyFunc(func);
+}
+
+void ALNS::addRepairFunc(const string& name) {
+    ALNSFunction* func = makeRepairFunc(name);
+    if (func == nullptr) throw "ALNS::addRepairFunc(): unknown repair function!";
+    this->addRepairFunc(func);
+}
+
+/**
+ * Removes (and deletes) every destroy and repair function, so a portfolio can be built from scratch
+ * Stepping a search before functions of both kinds are added back throws (see selectFuncs())
+ **/
+void ALNS::clearFuncs() {
+    for (auto &pair : this->destroyFuncs) {
+        delete pair.first;
+    }
+    for (auto &pair : this->repairFuncs) {
+        delete pair.first;
+    }
+    this->destroyFuncs.clear();
+    this->repairFuncs.clear();
+    this->buildTable(this->destroyTable, this->destroyFuncs);
+    this->buildTable(this->repairTable, this->repairFuncs);
+}
+
+/**
+ * Returns the registered functions, in selection order, with their current fitness and their statistics over the whole run
+ *
+ * @return {destroy: [{name, numToChange, fractionToChange, fitness, timesUsed, score, seconds, evaluations}, ...], repair: [...]}
+ **/
+string ALNS::getJSONFuncs() {
+    auto list = [](const vector<pair<ALNSFunction*, float>>& funcs) {
+        string json = "[";
+        for (int i = 0; i < (int) funcs.size(); i++) {
+            json += (i > 0 ? ", " : "");
+            json += "{name: \"" + funcs[i].first->getName() + "\"";
+            json += ", numToChange: " + to_string(funcs[i].first->getNumToChange());
+            json += ", fractionToChange: " + to_string(funcs[i].first->getFractionToChange());
+            json += ", fitness: "     + to_string(funcs[i].second);
+            json += ", timesUsed: "   + to_string(funcs[i].first->getTotalTimesUsed());
+            json += ", score: "       + to_string(funcs[i].first->getTotalScore());
+            json += ", seconds: "     + to_string(funcs[i].first->getTotalSeconds());
+            json += ", evaluations: " + to_string(funcs[i].first->getTotalEvaluations()) + "}";
+        }
+        return json + "]";
+    };
+    return "{destroy: " + list(this->destroyFuncs) + ", repair: " + list(this->repairFuncs) + "}";
 }
 
 void ALNS::resetFuncFitnesses() {
-    this->destroyFitnessSum = 0.0;
+    if (this->destroyFuncs.empty() || this->repairFuncs.empty()) {
+        throw "ALNS::resetFuncFitnesses(): needs at least one destroy and one repair function!";
+    }
     for (auto& func : this->destroyFuncs) {
-        this->destroyFitnessSum += 1.0;
         func.second = 1.0;
+        func.first->clearStats();
     }
-
-    this->repairFitnessSum = 0.0;
     for (auto& func : this->repairFuncs) {
-        this->repairFitnessSum += 1.0;
         func.second = 1.0;
+        func.first->clearStats();
+    }
+    this->buildTable(this->destroyTable, this->destroyFuncs);
+    this->buildTable(this->repairTable, this->repairFuncs);
+}
+
+// sets the size of every destroy function that follows p (repair functions fill whatever was destroyed)
+void ALNS::scaleFuncs() {
+    for (auto& func : this->destroyFuncs) {
+        func.first->scaleTo(this->data.numFacilities);
+    }
+}
+
+/**
+ * Rebuilds the alias table that samples the given functions by fitness
+ *
+ * @param AliasTable& table
+ * @param const vector<pair<ALNSFunction*, float>>& funcs
+ * @return void
+ **/
+void ALNS::buildTable(AliasTable& table, const vector<pair<ALNSFunction*, float>>& funcs) {
+    vector<float> fitnesses (funcs.size());
+    for (int i = 0; i < (int) funcs.size(); i++) {
+        fitnesses[i] = funcs[i].second;
     }
+    table.build(fitnesses);
 }
 
 /**
- * Generates an initial solution at random for our main optimizing loop to work with
- * Currently generates the solution by running a very, very short NDPSO
+ * Generates an initial solution for our main optimizing loop to work with
+ * Built by one of the constructive heuristics in Initializers.h (see initStrategy), or, with SWARM_INIT, by running a very, very short NDPSO
  *
  * @preconditions: assumes this.data has been set
- * @postconditions: promises not to change any members
+ * @postconditions: promises not to change any members besides drawing from this->rng
  * @return ALNSSolution --> a feasible initial solution
  **/
 ALNSSolution ALNS::generateInitialSolution() {
-    NDPSO* ndpso = new NDPSO(10);
-    ProblemResults results = ndpso->optimize(this->data);
-    delete ndpso;
-    ALNSSolution solution { this->data, results.objective, results.facilities, results.customerAssignments, 0};
-    return solution;
+    if (this->initStrategy == SWARM_INIT) {
+        NDPSO* ndpso = new NDPSO(10);
+        ndpso->setSeed(this->rng.next());
+        ProblemResults results = ndpso->optimize(this->data);
+        delete ndpso;
+        ALNSSolution solution { this->data, results.objective, results.facilities, results.customerAssignments, 0};
+        return solution;
+    }
 
+    vector<int> facilities = Initializers::construct(this->initStrategy, this->data, this->rng);
+    vector<int> assignments = this->data.assignCustomers(facilities);
+    ALNSSolution solution { this->data, this->data.evaluate(facilities), facilities, assignments, 0};
+    return solution;
 }
 
 /**
@@ -125,8 +248,8 @@ ALNSSolution ALNS::generateInitialSolution() {
  * @param: ALNSSolution initial --> initial problem solution
  **/
 void ALNS::calcStartingTemp(ALNSSolution initial) {
-    // hopefully my algebra is correct
-    this->temperature = initial.objective * (1.0 - startTempCtrl) / log(0.5);
+    // exp(-w * objective / T) = 0.5  =>  T = -w * objective / log(0.5), which is positive
+    this->temperature = -startTempCtrl * initial.objective / log(0.5);
 }
 
 /**
@@ -173,73 +296,108 @@ void ALNS::gridSearch(float lower, float upper, float step, void (ALNS::*setter)
 }
 
 /**
- * Optimizes a given problem using Adaptive Large Neighborhood Search
- * generates a starter solution at random, then destroys/repairs the solution in various ways
- * until we reach max number of iterations
+ * Sets up Adaptive Large Neighborhood Search for this->data
+ * generates a starter solution at random; each iteration then destroys/repairs the solution in various ways
  *
  * @preconditions: assumes parameters have been initialized
- * @postconditions: promises to attempt an optimal solution
- * @param ProblemData data --> the problem to solve (MAX_STAR or SUM_RADIUS)
- * @return ProblemResults --> an attempt at an optimal solution
+ * @postconditions: promises that currentSolution, bestSolution and temperature are ready for iterate()
+ **/
+void ALNS::setup() {
+    this->visited.clear();
+    resetFuncFitnesses();
+    scaleFuncs();
+    this->currentSolution = generateInitialSolution();
+    this->bestSolution    = this->currentSolution;
+    calcStartingTemp(this->currentSolution);
+}
+
+/**
+ * Sets up the search from a known solution instead of generating one
+ *
+ * @param const vector<int>& facilities
+ **/
+void ALNS::setupFrom(const vector<int>& facilities) {
+    this->visited.clear();
+    resetFuncFitnesses();
+    scaleFuncs();
+    this->currentSolution = { this->data, 0, facilities, {}, 0 };
+    this->currentSolution.update();
+    this->bestSolution = this->currentSolution;
+    calcStartingTemp(this->currentSolution);
+}
+
+/**
+ * Runs one destroy/repair/accept cycle
+ * 
+ * @preconditions: assumes setup() has run
+ * @postconditions: promises to keep bestSolution the best solution accepted so far
  **/
-ProblemResults ALNS::optimize(ProblemData data) {
-    clock_t begin = clock();
-    this->data = data;
-    this->comparator.setType(data.type.objective);
+void ALNS::iterate() {
     int outcome;
     float score;
     FuncPair funcs;
     ALNSFunction* repair;
     ALNSFunction* destroy;
-    ALNSSolution currentSolution, bestSolution, newSolution;
-    
-    // setup
-    resetFuncFitnesses();
-    currentSolution = generateInitialSolution();
-    bestSolution    = currentSolution;
-    calcStartingTemp(currentSolution);
-
-    for (int count = 1; count <= this->maxIterations; count++) {
-        funcs   = selectFuncs();
-        repair  = funcs.repair;
-        destroy = funcs.destroy;
-        newSolution = (*destroy)(currentSolution);
-        newSolution = (*repair)(newSolution);
-
-        if (accept(newSolution, currentSolution)) {
-            if (this->comparator(newSolution.objective, currentSolution.objective)) {
-                outcome = 2;
-            } else {
-                outcome = 3;
-            }
-            currentSolution = newSolution;
-
-            // if the solution is not accepted, there is no need to update the bestSolution,
-            // so this block is fine inside this if statement
-            if (this->comparator(currentSolution.objective, bestSolution.objective)) {
-                bestSolution = currentSolution;
-                outcome = 1;
-            }
+    ALNSSolution newSolution;
+
+    funcs   = selectFuncs();
+    repair  = funcs.repair;
+    destroy = funcs.destroy;
+
+    // the acceptance test's number is drawn up front, so the repair's evaluation can give up on a solution that can't pass it
+    float randNum = this->rng.nextInt(100) / 100.0;
+    auto start = chrono::steady_clock::now();
+    newSolution = (*destroy)(currentSolution);
+    auto destroyed = chrono::steady_clock::now();
+    newSolution.cutoff = acceptanceLimit(randNum);
+    newSolution.bound  = (newSolution.cutoff < INT_MAX ? &this->boundStats : nullptr);
+    newSolution = (*repair)(newSolution);
+    newSolution.bound  = nullptr;
+    auto repaired = chrono::steady_clock::now();
+    destroy->addToSeconds(chrono::duration<float>(destroyed - start).count());
+    repair->addToSeconds(chrono::duration<float>(repaired - destroyed).count());
+
+    if (accept(newSolution, currentSolution, randNum)) {
+        if (this->comparator(newSolution.objective, currentSolution.objective)) {
+            outcome = 2;
         } else {
-            outcome = 0;
+            outcome = 3;
         }
+        currentSolution = newSolution;
 
+        // if the solution is not accepted, there is no need to update the bestSolution,
+        // so this block is fine inside this if statement
+        if (this->comparator(currentSolution.objective, bestSolution.objective)) {
+            bestSolution = currentSolution;
+            outcome = 1;
+        }
+    } else {
+        outcome = 0;
+    }
 
-        // update temperature
-        this->temperature *= this->coolingFactor;
 
-        // update function scores for this segment
-        score = this->outcomeScores[outcome];
-        repair->addToScore(score);
-        destroy->addToScore(score);
+    // update temperature
+    this->temperature *= this->coolingFactor;
 
-        // update function fitnesses if we've hit the end of a segment
-        if (count % this->segmentLength == 0) {
-            updateFuncFitnesses();
-        }
+    // update function scores for this segment
+    score = this->outcomeScores[outcome];
+    repair->addToScore(score);
+    destroy->addToScore(score);
+
+    // update function fitnesses if we've hit the end of a segment
+    if (this->iteration % this->segmentLength == 0) {
+        updateFuncFitnesses();
     }
+}
+
+/**
+ * Returns the best solution found so far
+ *
+ * @return ProblemResults
+ **/
+ProblemResults ALNS::best() {
     ProblemResults results {
-                               float(clock() - begin) / CLOCKS_PER_SEC,
+                               this->elapsed,
                                bestSolution.objective,
                                bestSolution.facilities,
                                bestSolution.customerAssignments,
@@ -249,37 +407,134 @@ ProblemResults ALNS::optimize(ProblemData data) {
 }
 
 /**
- * Selects a set of destroy/repair functions using fitness (roulette wheel) selection
- * 
- * @preconditions:
- * @postcondition:
- * @return FuncPair --> struct containing pointers to repair/destroy functional objects
+ * Writes everything iterate() depends on: parameters, temperature, function fitnesses and segment scores,
+ * the visited solutions and the current/best solutions
+ *
+ * @param SnapshotWriter& out
+ * @return void
  **/
-FuncPair ALNS::selectFuncs() {
-    FuncPair funcs;
+void ALNS::saveState(SnapshotWriter& out) {
+    out.putInt(this->segmentLength);
+    out.putFloat(this->reactionFactor);
+    out.putFloat(this->coolingFactor);
+    out.putFloat(this->startTempCtrl);
+    out.putFloat(this->temperature);
+    out.putInt(this->weightScheme);
+    for (float score : this->outcomeScores) {
+        out.putFloat(score);
+    }
+    this->saveFuncs(out, this->destroyFuncs);
+    this->saveFuncs(out, this->repairFuncs);
 
-    // choose a destroy function
-    float runningSum = 0.0;
-    float randNum = (rand() % 100 + 1) / 100.0 * destroyFitnessSum;
-    for (auto pair : destroyFuncs) {
-        runningSum += pair.second;
-        if (runningSum >= randNum) {
-            funcs.destroy = pair.first;
-            break;
-        }
+    out.putInt(this->visited.size());
+    for (auto& pair : this->visited) {
+        out.putString(pair.first);
     }
+    this->saveSolution(out, this->currentSolution);
+    this->saveSolution(out, this->bestSolution);
+}
 
-    // choose a repair function
-    randNum = (rand() % 100 + 1) / 100.0 * repairFitnessSum;
-    runningSum = 0.0;
-    for (auto pair : repairFuncs) {
-        runningSum += pair.second;
-        if (runningSum >= randNum) {
-            funcs.repair = pair.first;
-            break;
-        }
+/**
+ * Reads back what saveState() wrote
+ *
+ * @param SnapshotReader& in
+ * @return void
+ **/
+void ALNS::loadState(SnapshotReader& in) {
+    this->segmentLength  = in.getInt();
+    this->reactionFactor = in.getFloat();
+    this->coolingFactor  = in.getFloat();
+    this->startTempCtrl  = in.getFloat();
+    this->temperature    = in.getFloat();
+    this->weightScheme   = (WeightScheme) in.getInt();
+    for (float& score : this->outcomeScores) {
+        score = in.getFloat();
+    }
+    this->loadFuncs(in, this->destroyFuncs);
+    this->loadFuncs(in, this->repairFuncs);
+    this->buildTable(this->destroyTable, this->destroyFuncs);
+    this->buildTable(this->repairTable, this->repairFuncs);
+
+    this->visited.clear();
+    int numVisited = in.getInt();
+    for (int i = 0; i < numVisited; i++) {
+        this->visited[in.getString()] = true;
     }
+    this->currentSolution = this->loadSolution(in);
+    this->bestSolution    = this->loadSolution(in);
+}
+
+void ALNS::saveFuncs(SnapshotWriter& out, const vector<pair<ALNSFunction*, float>>& funcs) {
+    out.putInt(funcs.size());
+    for (auto& pair : funcs) {
+        out.putString(pair.first->getName());
+        out.putFloat(pair.second);
+        out.putFloat(pair.first->getScore());
+        out.putInt(pair.first->getTimesUsed());
+        out.putInt(pair.first->getNumToChange());
+        out.putFloat(pair.first->getFractionToChange());
+        out.putFloat(pair.first->getSeconds());
+        out.putInt(pair.first->getEvaluations());
+        // the totals without this segment, which was just written
+        out.putUint64(pair.first->getTotalTimesUsed() - pair.first->getTimesUsed());
+        out.putFloat(pair.first->getTotalScore() - pair.first->getScore());
+        out.putFloat(pair.first->getTotalSeconds() - pair.first->getSeconds());
+        out.putUint64(pair.first->getTotalEvaluations() - pair.first->getEvaluations());
+    }
+}
+
+void ALNS::loadFuncs(SnapshotReader& in, vector<pair<ALNSFunction*, float>>& funcs) {
+    if (in.getInt() != (int)funcs.size()) throw "ALNS::loadFuncs(): checkpoint has a different set of functions!";
+    for (auto& pair : funcs) {
+        if (in.getString() != pair.first->getName()) throw "ALNS::loadFuncs(): checkpoint has a different set of functions!";
+        pair.second = in.getFloat();
+        pair.first->setScore(in.getFloat());
+        pair.first->setTimesUsed(in.getInt());
+        pair.first->setNumToChange(in.getInt());
+        pair.first->setFractionToChange(in.getFloat());
+        pair.first->setSeconds(in.getFloat());
+        pair.first->setEvaluations(in.getInt());
+        long long timesUsed   = in.getUint64();
+        float     score       = in.getFloat();
+        float     seconds     = in.getFloat();
+        long long evaluations = in.getUint64();
+        pair.first->setTotals(timesUsed, score, seconds, evaluations);
+    }
+}
+
+// saved as-is rather than recalculated with update(): ties between facilities are broken by their order,
+// so the facilities keep the order the objective was calculated in
+void ALNS::saveSolution(SnapshotWriter& out, const ALNSSolution& solution) {
+    out.putInt(solution.objective);
+    out.putVector(solution.facilities);
+    out.putVector(solution.customerAssignments);
+}
 
+ALNSSolution ALNS::loadSolution(SnapshotReader& in) {
+    ALNSSolution solution;
+    solution.data = this->data;
+    solution.objective = in.getInt();
+    solution.facilities = in.getVector();
+    solution.customerAssignments = in.getVector();
+    solution.numUnassigned = 0;
+    solution.bound = nullptr;
+    return solution;
+}
+
+/**
+ * Selects a set of destroy/repair functions using fitness (roulette wheel) selection
+ * Each draw is O(1) whatever the number of functions: the alias tables are rebuilt when the fitnesses change, not here
+ * Throws if either kind has no functions (e.g. clearFuncs() was called after init() and nothing was added back)
+ * 
+ * @return FuncPair --> struct containing pointers to repair/destroy functional objects
+ **/
+FuncPair ALNS::selectFuncs() {
+    if (this->destroyFuncs.empty() || this->repairFuncs.empty()) {
+        throw "ALNS::selectFuncs(): no destroy or no repair functions registered!";
+    }
+    FuncPair funcs;
+    funcs.destroy = this->destroyFuncs[this->destroyTable.sample(this->rng)].first;
+    funcs.repair  = this->repairFuncs[this->repairTable.sample(this->rng)].first;
     return funcs;
 }
 
@@ -288,25 +543,24 @@ FuncPair ALNS::selectFuncs() {
  * Two criteria:
  *     1) Has the solution been visited before? --> checks a hash table of solutions
  *     2) Does the solution pass a simulated annealing acceptance test?
- *         -- accepted with probability e ^ (-(fitness(newSolution) - fitness(currentSolution)) / Temperature)
+ *         -- accepted with probability e ^ (-(how much worse newSolution is than currentSolution) / Temperature)
  * @preconditions: assumes that starting temperature has been calculated and set
  *                 assumes that both solutions are feasible
  *                 assumes that the hash table of visited solutions has been initialized (i.e., is not null)
  * @postconditions: promises that if the new solution is accepted, it will be hashed and added to the visited solutions
  * @param ProblemResults newSolution: the destroyed/repaired version of oldSolution
  * @param ProblemResults oldSolution: the solution from the previous iteration
+ * @param float randNum: this iteration's random number in [0, 1)
  * @return bool --> whether the new solution is acceptable
  **/
-bool ALNS::accept(ALNSSolution& newSolution, ALNSSolution& currentSolution) {
+bool ALNS::accept(ALNSSolution& newSolution, ALNSSolution& currentSolution, float randNum) {
     bool shouldAccept = false;
     string hash = newSolution.getHash();
     if (visited.count(hash) > 0) {
         return false;
     }
 
-    float randNum = (rand() % 100) / 100.0;
-    float acceptanceChance = exp((currentSolution.objective - newSolution.objective) / this->temperature);
-    if (randNum <= acceptanceChance) {
+    if (passes(randNum, currentSolution.objective, newSolution.objective)) {
         shouldAccept = true;
         visited[hash] = true;
     }
@@ -314,35 +568,90 @@ bool ALNS::accept(ALNSSolution& newSolution, ALNSSolution& currentSolution) {
     return shouldAccept;
 }
 
+/**
+ * The simulated annealing acceptance test on its own
+ * A candidate no worse than the current solution always passes; one worse by d passes with probability e ^ (-d / temperature)
+ *
+ * @param float randNum
+ * @param int current: objective of the current solution
+ * @param int candidate: objective of the new solution
+ * @return bool
+ **/
+bool ALNS::passes(float randNum, int current, int candidate) {
+    float worsening = (this->data.type.objective == MINIMIZE ? (float) candidate - current : (float) current - candidate);
+    if (worsening <= 0) return true;
+    float acceptanceChance = exp(-worsening / this->temperature);
+    return randNum <= acceptanceChance;
+}
+
+/**
+ * The worst objective a new solution can have and still pass the acceptance test with the given random number,
+ * so that anything proven worse than it can be rejected without evaluating it in full
+ * Found by bisecting passes() itself (it only gets harder to pass as the objective grows), so it agrees with accept() exactly
+ * Only minimizing with a positive temperature has such a limit
+ *
+ * @param float randNum
+ * @return int limit, or INT_MAX if there's none
+ **/
+int ALNS::acceptanceLimit(float randNum) {
+    int current = this->currentSolution.objective;
+    if (this->data.type.objective != MINIMIZE || this->temperature <= 0 || !passes(randNum, current, current)) {
+        return INT_MAX;
+    }
+
+    // gallop out to an objective that fails, then bisect between it and the last one that passed
+    long long passing = current, failing = current + 1;
+    for (long long step = 2; passes(randNum, current, (int) failing); step *= 2) {
+        passing = failing;
+        failing = current + step;
+        if (failing >= INT_MAX) return INT_MAX;
+    }
+    while (failing - passing > 1) {
+        long long middle = passing + (failing - passing) / 2;
+        if (passes(randNum, current, (int) middle)) {
+            passing = middle;
+        } else {
+            failing = middle;
+        }
+    }
+    return (int) passing;
+}
+
 /**
  * Updates the fitness of our facility functions based on their scores over the last segment
  * At the end of a segment (NOT an iteration!), update the "fitness" of each function using this formula:
- *     p<new> = p<old>(1 - r) + r(score<heuristic> / number of times we used the heuristic in the last segment)
+ *     p<new> = p<old>(1 - r) + r(score<heuristic> / cost of the heuristic in the last segment)
+ * where the cost is what weightScheme says: the number of times we used the heuristic, the milliseconds it took,
+ * or the objective evaluations it made
  * 
- * @preconditions: assumes we've run a whole segment, and that each heuristic has been used at least once
- * @postconditions: 1) updates the MAP of function fitnesses
- *                  2) updates the SUMS of function fitnesses
+ * @preconditions: assumes we've run a whole segment; a heuristic that wasn't used keeps its fitness
+ * @postconditions: 1) updates the function fitnesses
+ *                  2) rebuilds the alias tables that selectFuncs() samples them with
  **/    
 void ALNS::updateFuncFitnesses() {
-    // destroy functions
-    destroyFitnessSum = 0.0;
     for (auto &pair : destroyFuncs) {
-        if (pair.first->getTimesUsed() > 0) {
-            pair.second = pair.second * (1.0 - reactionFactor) + 
-                            reactionFactor * (pair.first->getScore() / pair.first->getTimesUsed());
-        }
-        pair.first->reset();
-        destroyFitnessSum += pair.second;
+        updateFuncFitness(pair);
     }
-
-    // repair functions
-    repairFitnessSum = 0.0;
     for (auto &pair : repairFuncs) {
-        if (pair.first->getTimesUsed() > 0) {
-            pair.second = pair.second * (1.0 - reactionFactor) + 
-                            reactionFactor * (pair.first->getScore() / pair.first->getTimesUsed());
+        updateFuncFitness(pair);
+    }
+
+    this->buildTable(this->destroyTable, this->destroyFuncs);
+    this->buildTable(this->repairTable, this->repairFuncs);
+}
+
+void ALNS::updateFuncFitness(pair<ALNSFunction*, float>& entry) {
+    ALNSFunction* func = entry.first;
+    if (func->getTimesUsed() > 0) {
+        float cost = func->getTimesUsed();
+        if (this->weightScheme == PER_MILLISECOND) {
+            cost = func->getSeconds() * 1000;
+        } else if (this->weightScheme == PER_EVALUATION) {
+            cost = max(func->getEvaluations(), func->getTimesUsed());
+        }
+        if (cost > 0) {
+            entry.second = entry.second * (1.0 - reactionFactor) + reactionFactor * (func->getScore() / cost);
         }
-        pair.first->reset();
-        repairFitnessSum += pair.second;
     }
-}
\ No newline at end of file
+    func->reset();
+}
@@ -3,9 +3,12 @@
 
 #include <map>
 #include <vector>
+#include <utility>
 #include "Algorithm.h"
 #include "ALNSSolution.h"
+#include "AliasTable.h"
 #include "ALNSFunction.h"
+#include "Initializers.h"
 #include "alns-functions.h"
 using namespace std;
 
@@ -16,16 +19,42 @@ const float REACTION_FACTOR = 0.8;
 const float COOLING_FACTOR  = 0.99985;
 const float START_TEMP_CTRL = 0.4;
 
+// sizes of the default destroy functions, as fractions of p (0 for a single facility)
+// every destroy function is registered once per size, so the sizes compete for selection like any other functions
+const float DESTROY_FRACTIONS[] = { 0.0, 0.1, 0.25 };
+
+// what updateFuncFitnesses() divides a function's score over a segment by
+enum WeightScheme {
+    PER_USE,            // the number of times it was used (classic ALNS)
+    PER_MILLISECOND,    // the time spent in it, so fitness is reward per millisecond; runs are then no longer reproducible by seed
+    PER_EVALUATION      // the objective evaluations it made (at least one per use), a reproducible stand-in for its time
+};
+
 
 
 class ALNS : public Algorithm {
 public:
     ALNS();                    // what constructors might I need? What would I want to pass in?
     ~ALNS();
-    ProblemResults optimize(ProblemData);
     string getName() { return "ALNS"; }
     string getJSONParameters();
+    ProblemResults best() override;
+
+
+    // operator registry; ALNS owns (and deletes) every function it's given
+    void addDestroyFunc(ALNSFunction*);
+    void addRepairFunc(ALNSFunction*);
+    void addDestroyFunc(const string&, int);    // by name (see makeDestroyFunc()), destroying q facilities
+    void addRepairFunc(const string&);          // by name (see makeRepairFunc())
+    void addScaledDestroyFunc(const string&, float);    // by name, destroying a fraction of p (see ALNSFunction::scaleTo())
+    void clearFuncs();
+    string getJSONFuncs();
+
+    void setWeightScheme(WeightScheme val) { this->weightScheme = val; }
+    WeightScheme getWeightScheme() { return this->weightScheme; }
 
+    void setInitStrategy(InitStrategy val) { this->initStrategy = val; }
+    InitStrategy getInitStrategy() { return this->initStrategy; }
 
     void setStartTempCtrl(float val) { this->startTempCtrl = val; }
     float getStartTempCtrl() { return this->startTempCtrl; }
@@ -44,6 +73,12 @@ public:
     
     void setAcceptedWorseReward(float val) { this->outcomeScores[3] = val; }
     float getAcceptedWorseReward() { return this->outcomeScores[3]; }
+protected:
+    void setup() override;
+    void setupFrom(const vector<int>&) override;
+    void iterate() override;
+    void saveState(SnapshotWriter&) override;
+    void loadState(SnapshotReader&) override;
 private:
     /**
      * Helper Functions
@@ -51,31 +86,43 @@ private:
     void gridSearch(float, float, float, void (ALNS::*)(float));
     void initDefaultFuncs();
     void resetFuncFitnesses();
+    void buildTable(AliasTable&, const vector<pair<ALNSFunction*, float>>&);
+    void scaleFuncs();
     ALNSSolution generateInitialSolution();
     void calcStartingTemp(ALNSSolution);
     FuncPair selectFuncs();
-    bool accept(ALNSSolution&, ALNSSolution&);
+    bool accept(ALNSSolution&, ALNSSolution&, float);
+    bool passes(float, int, int);
+    int  acceptanceLimit(float);
     void updateFuncFitnesses();
+    void updateFuncFitness(pair<ALNSFunction*, float>&);
+    void saveFuncs(SnapshotWriter&, const vector<pair<ALNSFunction*, float>>&);
+    void loadFuncs(SnapshotReader&, vector<pair<ALNSFunction*, float>>&);
+    void saveSolution(SnapshotWriter&, const ALNSSolution&);
+    ALNSSolution loadSolution(SnapshotReader&);
 
     /**
      * Parameters
      **/
-    int   maxIterations;
     int   segmentLength;
     float reactionFactor;
     float coolingFactor;
     float startTempCtrl;
     float temperature;
     float outcomeScores[4] = {0.0, 3.0, 15.0, 24.0};
+    InitStrategy initStrategy = AUTO_INIT;     // how setup() builds the starting solution
+    WeightScheme weightScheme = PER_USE;
 
     /**
      * Working data
      **/
     map<string, bool> visited;
-    map<ALNSFunction*, float> destroyFuncs;
-    map<ALNSFunction*, float> repairFuncs;
-    float destroyFitnessSum;
-    float repairFitnessSum;
+    ALNSSolution currentSolution;
+    ALNSSolution bestSolution;
+    vector<pair<ALNSFunction*, float>> destroyFuncs;   // function and its fitness, kept in the order they were added
+    vector<pair<ALNSFunction*, float>> repairFuncs;    // so that selection (and a resumed checkpoint) doesn't depend on pointer values
+    AliasTable destroyTable;    // samples destroyFuncs by fitness, rebuilt whenever the fitnesses change
+    AliasTable repairTable;
 };
 
 #endif
@@ -3,8 +3,12 @@
 
 #include <map>
 #include <vector>
+#include <cmath>
+#include <string>
+#include <algorithm>
 #include "defs.h"
 #include "Utils.h"
+#include "Random.h"
 #include "ALNSSolution.h"
 using namespace std;
 
@@ -14,24 +18,81 @@ using namespace std;
  **/
 class ALNSFunction {
 public:
-    ALNSFunction() { this->numToChange = 1; this->score = 0.0; this->timesUsed = 0; }
+    ALNSFunction() { this->numToChange = 1; this->clearStats(); }
     ALNSFunction(int q) : ALNSFunction() { this->numToChange = q; }
+    virtual ~ALNSFunction() {}
     virtual ALNSSolution operator()(ALNSSolution) = 0;
+    virtual string getName() = 0;   // what ALNS registers it under (see ALNS::addDestroyFunc() and ALNS::addRepairFunc())
 
     void setNumToChange(int q) { this->numToChange = q; }
     int  getNumToChange() { return this->numToChange; }
+    // how many of the given number of facilities to change: numToChange, but never more than there are
+    int  numToChangeOf(int size) { return min(this->numToChange, size); }
 
+    // if set, numToChange follows the number of facilities: round(fraction * p), at least 1 and at most p (see scaleTo())
+    void  setFractionToChange(float val) { this->fractionToChange = val; }
+    float getFractionToChange() { return this->fractionToChange; }
+    void  scaleTo(int numFacilities) {
+        if (this->fractionToChange > 0) {
+            this->numToChange = max(1, min(numFacilities, (int) round(this->fractionToChange * numFacilities)));
+        }
+    }
+
+    // this segment's statistics (see ALNS::updateFuncFitnesses())
     void  addToScore(float addition) { this->score += addition; }
+    void  setScore(float val) { this->score = val; }
     float getScore() { return this->score; }
 
-    int getTimesUsed() { return this->timesUsed; }
+    void setTimesUsed(int val) { this->timesUsed = val; }
+    int  getTimesUsed() { return this->timesUsed; }
+
+    void  addToSeconds(float addition) { this->seconds += addition; }
+    void  setSeconds(float val) { this->seconds = val; }
+    float getSeconds() { return this->seconds; }
+
+    void setEvaluations(int val) { this->evaluations = val; }
+    int  getEvaluations() { return this->evaluations; }
 
-    void reset() { this->score = 0.0; this->timesUsed = 0; }
+    // the whole run's statistics, this segment included
+    long long getTotalTimesUsed()   { return this->total.timesUsed + this->timesUsed; }
+    double    getTotalScore()       { return this->total.score + this->score; }
+    double    getTotalSeconds()     { return this->total.seconds + this->seconds; }
+    long long getTotalEvaluations() { return this->total.evaluations + this->evaluations; }
+    void setTotals(long long timesUsed, double score, double seconds, long long evaluations) {
+        this->total = { timesUsed, score, seconds, evaluations };
+    }
+
+    void setRandom(Random* rng) { this->rng = rng; }
+
+    // ends a segment: its statistics go into the totals
+    void reset() {
+        this->total.timesUsed   += this->timesUsed;
+        this->total.score       += this->score;
+        this->total.seconds     += this->seconds;
+        this->total.evaluations += this->evaluations;
+        this->score = 0.0; this->timesUsed = 0; this->seconds = 0.0; this->evaluations = 0;
+    }
+    void clearStats() {
+        this->score = 0.0; this->timesUsed = 0; this->seconds = 0.0; this->evaluations = 0;
+        this->total = { 0, 0.0, 0.0, 0 };
+    }
     
 protected:
     int   numToChange;
+    float fractionToChange = 0.0;
     float score;
     int timesUsed = 0;
+    float seconds;      // time spent in operator() (measured by ALNS::iterate())
+    int evaluations;    // objective evaluations made; every function counts its own
+    Random* rng = nullptr;  // owned by the ALNS this function belongs to
+
+private:
+    struct Totals {
+        long long timesUsed;
+        double    score;
+        double    seconds;
+        long long evaluations;
+    } total;            // every finished segment's statistics
 };
 
 #endif
\ No newline at end of file
@@ -6,6 +6,22 @@
 #include "ProblemData.h"
 using namespace std;
 
+/**
+ * Constructor for a solution with no cutoff or bound set (see update())
+ *
+ * @param const ProblemData& data
+ * @param int objective
+ * @param const vector<int>& facilities
+ * @param const vector<int>& customerAssignments
+ * @param int numUnassigned
+ **/
+ALNSSolution::ALNSSolution(const ProblemData& data, int objective, const vector<int>& facilities, const vector<int>& customerAssignments, int numUnassigned) {
+    this->data = data;
+    this->objective = objective;
+    this->facilities = facilities;
+    this->customerAssignments = customerAssignments;
+    this->numUnassigned = numUnassigned;
+}
 
 string ALNSSolution::getJSONFacilities() {
     string json = "[";
@@ -27,22 +43,29 @@ string ALNSSolution::getJSONCustomers() {
 
 string ALNSSolution::getHash() {
     string hash = "";                           // since order doesn't matter, we need to sort the facilities to make sure that
-    sort(facilities.begin(), facilities.end()); // solutions with different orders of the same facilities get hashed the same
-    for (int fac : facilities) { hash += to_string(fac); }
+    vector<int> sorted (facilities);            // solutions with different orders of the same facilities get hashed the same
+    sort(sorted.begin(), sorted.end());         // (a copy, so the order update() last saw is kept for the next update())
+    for (int fac : sorted) { hash += to_string(fac); }
     return hash;
 }
 
 /**
- * Sorts facilities vector by appropriate measures
+ * The facilities sorted by appropriate measures, best first
+ * A sorted copy: the facilities vector keeps its order, which is the order update() last saw (see removeFacilities())
  * 
- * @return void
+ * @return vector<int> sorted facilities
  **/
-void ALNSSolution::sortFacsByMeasures() {
-    // turn the measures map into a vector of pairs
-    map<int, int> measures = this->data.getMeasures(this->customerAssignments);
+vector<int> ALNSSolution::getFacsByMeasures() {
+    // the measures update() kept, in facility order like the measures map, or the map itself if the facilities changed since
     vector<pair<int, int>> pairs;
-    for (auto itr = measures.begin(); itr != measures.end(); ++itr) {
-        pairs.push_back(*itr);
+    if (this->state.getFacilities() == this->facilities) {
+        pairs = this->state.getMeasures();
+        sort(pairs.begin(), pairs.end());
+    } else {
+        map<int, int> measures = this->data.getMeasures(this->customerAssignments);
+        for (auto itr = measures.begin(); itr != measures.end(); ++itr) {
+            pairs.push_back(*itr);
+        }
     }
     // sort the vector of pairs in ascending order
     Comparator comparator(this->data.type.objective);
@@ -51,19 +74,51 @@ void ALNSSolution::sortFacsByMeasures() {
             return comparator(a.second, b.second);
         }
     );
-    // copy the new order into the facilities vector
-    int i = 0;
+    // facilities with no customers have no measure, so they go last, in their old order
+    vector<bool> measured (this->data.numCandidates, false);
+    for (auto pair : pairs) {
+        measured[pair.first] = true;
+    }
+    vector<int> sorted;
+    sorted.reserve(this->facilities.size());
     for (auto pair : pairs) {
-        this->facilities[i++] = pair.first;
+        sorted.push_back(pair.first);
     }
+    for (int fac : this->facilities) {
+        if (!measured[fac]) sorted.push_back(fac);
+    }
+    return sorted;
+}
+
+/**
+ * Closes the given facilities, keeping the rest in their order, so the next update() only applies the removal
+ * (see IncrementalObjective::follow(), which needs the facilities it kept to come in the same order)
+ *
+ * @param const vector<int>& removed: facilities to close, each open and at most once
+ * @return void
+ **/
+void ALNSSolution::removeFacilities(const vector<int>& removed) {
+    auto closed = [&](int fac) { return find(removed.begin(), removed.end(), fac) != removed.end(); };
+    this->facilities.erase(remove_if(this->facilities.begin(), this->facilities.end(), closed), this->facilities.end());
+    this->numUnassigned += removed.size();
 }
 
 /**
  * Updates customer assignments and objective
+ * Only the facilities erased and appended since the last update() are applied (see IncrementalObjective::follow()),
+ * unless there are too few facilities for that to pay and a bound is set, in which case this is a bounded evaluation:
+ * if it gives up, objective is just something worse than cutoff and the customer assignments are stale
  *
  * @return void
  **/
 void ALNSSolution::update() {
-    this->customerAssignments = this->data.assignCustomers(this->facilities);
-    this->objective = this->data.calcObjective(this->customerAssignments);
+    if (this->bound != nullptr && (int) this->facilities.size() < INCREMENTAL_MIN_FACILITIES && this->data.isBoundable()) {
+        int scanned;
+        this->objective = this->data.evaluateBounded(this->facilities, this->cutoff, &this->customerAssignments, &scanned);
+        this->bound->add(scanned, this->data.numCustomers);
+        return;
+    }
+    this->state.follow(this->data, this->facilities);
+    this->objective = this->state.getObjective();
+    this->state.getAssignments(this->customerAssignments);
 }
\ No newline at end of file
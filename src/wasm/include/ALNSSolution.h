@@ -3,25 +3,33 @@
 
 #include <map>
 #include <vector>
+#include <climits>
 #include <algorithm>
 #include "ProblemData.h"
+#include "IncrementalObjective.h"
 using namespace std;
 
 class ALNSSolution {
 public:
     /* members */
     ProblemData data;
-    int objective;
+    int objective = 0;
     vector<int> facilities;
     vector<int> customerAssignments;
-    int numUnassigned;
+    int numUnassigned = 0;
+    int cutoff = INT_MAX;           // if bound is set, update() may give up once the objective is proven worse than cutoff
+    BoundStats* bound = nullptr;    // (see ALNS::iterate()), counting what that saved into *bound
+    IncrementalObjective state;     // assignments and measures as of the last update(), so the next one only applies the changes
 
     /* functions */
+    ALNSSolution() {}
+    ALNSSolution(const ProblemData&, int, const vector<int>&, const vector<int>&, int);  // data, objective, facilities, assignments, numUnassigned
     string getJSONFacilities();
     string getJSONCustomers();
     string getHash();
     map<int, int> getMeasures();
-    void sortFacsByMeasures();
+    vector<int> getFacsByMeasures();
+    void removeFacilities(const vector<int>&);
     map<int, int> getStars();
     map<int, int> getRadii();
     map<int, int> getRays();
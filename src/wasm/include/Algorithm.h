@@ -1,8 +1,13 @@
 #ifndef ALGORITHM_H
 #define ALGORITHM_H
 
+#include <atomic>
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include "defs.h"
+#include "Random.h"
+#include "Snapshot.h"
 #include "Listener.h"
 #include "Comparator.h"
 #include "ProblemData.h"
@@ -13,23 +18,268 @@ class Logger;
 
 /**
  * Abstract class that defines contract for any potential algorithms to implement
+ *
+ * A search can either be run in one go with optimize(), or driven cooperatively:
+ *     init(problem), then step()/stepFor() as often as the caller likes, then best()
+ * cancel() ends the search at the next iteration boundary, so a UI thread or a worker can interleave
+ * solving with other work and stop whenever it wants. Subclasses only implement setup() and iterate(),
+ * plus saveState()/loadState() so that checkpoint() and resume() can carry a search across processes.
  **/
 class Algorithm {
 public:
     virtual ~Algorithm() {};
-    virtual ProblemResults optimize(ProblemData) = 0;
+    virtual ProblemResults optimize(ProblemData data) {
+        this->init(data);
+        this->step(this->maxIterations);
+        return this->best();
+    }
     // should remove these calls entirely, I think
     virtual int calcObjective(const vector<int>& assignments) { 
         return this->data.calcObjective(assignments); 
     };
     virtual string getName() = 0;
     virtual string getJSONParameters() = 0;
+    virtual ProblemResults best() = 0;
     void      setListener(Listener* l) { this->listener = l; };
     Listener* getListener() { return this->listener; };
+
+    /**
+     * Loads a problem and builds the starting state of the search
+     *
+     * @param ProblemData data
+     * @return void
+     **/
+    void init(ProblemData data) {
+        this->start(data, nullptr);
+    }
+
+    /**
+     * Like init(), but builds the starting state around a known solution instead of from scratch
+     *
+     * @param ProblemData data
+     * @param const vector<int>& facilities (exactly data.numFacilities distinct facilities)
+     * @return void
+     **/
+    void warmStart(ProblemData data, const vector<int>& facilities) {
+        if ((int) facilities.size() != data.numFacilities) throw "Algorithm::warmStart(): wrong number of facilities!";
+        vector<bool> seen (data.numCandidates, false);
+        for (int fac : facilities) {
+            if (fac < 0 || fac >= data.numCandidates) throw "Algorithm::warmStart(): facility out of range!";
+            if (seen[fac]) throw "Algorithm::warmStart(): duplicate facility!";
+            seen[fac] = true;
+        }
+        this->start(data, &facilities);
+    }
+
+    /**
+     * Re-solves a problem that changed slightly since it was last solved
+     * Applies the delta to data in place, carries the previous facilities over (greedily filling/trimming them
+     * to the new number of facilities), warm starts from them and searches for what's left of the given wall-clock budget
+     *
+     * @param ProblemData& data (the problem previous was found on; updated to the changed problem)
+     * @param const ProblemResults& previous
+     * @param const ProblemDelta& delta
+     * @param float ms
+     * @return ProblemResults
+     **/
+    ProblemResults reoptimize(ProblemData& data, const ProblemResults& previous, const ProblemDelta& delta, float ms) {
+        auto begin = chrono::steady_clock::now();
+        vector<int> newIndex = data.applyDelta(delta);
+        vector<int> facilities;
+        for (int fac : previous.facilities) {
+            if (fac < 0 || fac >= (int) newIndex.size()) throw "Algorithm::reoptimize(): facility out of range!";
+            if (newIndex[fac] != -1) {
+                facilities.push_back(newIndex[fac]);
+            }
+        }
+        this->deadline = begin + toDuration(ms);       // the warm start counts against the budget too
+        this->warmStart(data, data.fitFacilities(facilities));
+        this->deadline = chrono::steady_clock::time_point::max();
+        float spent = chrono::duration<float, milli>(chrono::steady_clock::now() - begin).count();
+        this->stepFor(max(ms - spent, 0.0f));
+        return this->best();
+    }
+
+    /**
+     * Runs up to the given number of iterations, stopping early if the search is done or cancelled
+     *
+     * @preconditions: assumes init() has been called
+     * @param int iterations
+     * @return int number of iterations actually run
+     **/
+    virtual int step(int iterations) {
+        auto begin = chrono::steady_clock::now();
+        int ran = 0;
+        while (ran < iterations && !this->isDone()) {
+            this->iteration++;
+            this->iterate();
+            ran++;
+            if (this->isCheckpointDue()) {
+                auto now = chrono::steady_clock::now();
+                this->elapsed += chrono::duration<float>(now - begin).count();
+                begin = now;
+                this->saveCheckpoint();
+            }
+        }
+        this->elapsed += chrono::duration<float>(chrono::steady_clock::now() - begin).count();
+        return ran;
+    }
+
+    /**
+     * Runs iterations until the given wall-clock budget is spent (always runs at least one unless done)
+     * Steps in chunks sized from the iterations timed so far, so the clock isn't polled every iteration;
+     * an iteration that can run long on its own checks isOutOfTime() to stop at the budget anyway
+     *
+     * @preconditions: assumes init() has been called
+     * @param float ms
+     * @return int number of iterations actually run
+     **/
+    int stepFor(float ms) {
+        auto begin = chrono::steady_clock::now();
+        int ran = 0;
+        int chunk = 1;
+        this->deadline = begin + toDuration(ms);
+        while (!this->isDone()) {
+            ran += this->step(chunk);
+            float spent = chrono::duration<float, milli>(chrono::steady_clock::now() - begin).count();
+            if (spent >= ms) break;
+            // aim for half of the remaining budget so we don't overshoot it by much
+            float perIteration = spent / ran;
+            chunk = (perIteration > 0 ? int((ms - spent) / perIteration / 2) : chunk * 2);
+            if (chunk < 1) chunk = 1;
+        }
+        this->deadline = chrono::steady_clock::time_point::max();
+        return ran;
+    }
+
+    /**
+     * Snapshots the whole state of the search, generator included
+     * Resuming the snapshot on the same problem continues exactly as if the search had never stopped
+     * The problem itself isn't included; only enough of it to recognize it again
+     *
+     * @preconditions: assumes init() or resume() has been called
+     * @return string bytes (see Snapshot.h)
+     **/
+    string checkpoint() {
+        SnapshotWriter out;
+        out.putString(this->getName());
+        out.putString(this->data.name);
+        out.putInt(this->data.numCustomers);
+        out.putInt(this->data.numCandidates);
+        out.putInt(this->data.numFacilities);
+        out.putInt(this->data.type.objective);
+        out.putInt(this->data.type.aggregate);
+        out.putInt(this->data.type.measure);
+        out.putInt(this->iteration);
+        out.putInt(this->maxIterations);
+        out.putFloat(this->elapsed);
+        out.putUint64(this->rng.getState());
+        this->saveState(out);
+        return out.finish();
+    }
+
+    /**
+     * Continues a search from a checkpoint() instead of starting over with init()
+     *
+     * @param ProblemData data (the same problem the checkpoint was taken on)
+     * @param const string& checkpoint
+     * @return void
+     **/
+    void resume(ProblemData data, const string& checkpoint) {
+        SnapshotReader in (checkpoint);
+        if (in.getString() != this->getName()) throw "Algorithm::resume(): checkpoint is for a different algorithm!";
+        string name = in.getString();
+        int numCustomers  = in.getInt();
+        int numCandidates = in.getInt();
+        int numFacilities = in.getInt();
+        ProblemType type { (Objective)in.getInt(), (Aggregate)in.getInt(), (Measure)in.getInt() };
+        if (name != data.name || numCustomers != data.numCustomers || numCandidates != data.numCandidates || numFacilities != data.numFacilities ||
+                type.objective != data.type.objective || type.aggregate != data.type.aggregate || type.measure != data.type.measure) {
+            throw "Algorithm::resume(): checkpoint is for a different problem!";
+        }
+
+        this->data = data;
+        this->comparator.setType(data.type.objective);
+        this->cancelled = false;
+        this->boundStats = BoundStats();
+        this->iteration = in.getInt();
+        this->maxIterations = in.getInt();
+        this->elapsed = in.getFloat();
+        this->rng.setState(in.getUint64());
+        this->loadState(in);
+    }
+
+    /**
+     * Takes a checkpoint every so many iterations while stepping (0 turns it off)
+     * Each one replaces getLastCheckpoint() and is handed to the listener's handleCheckpoint()
+     *
+     * @param int iterations
+     * @return void
+     **/
+    void setCheckpointInterval(int iterations) { this->checkpointInterval = iterations; }
+    int  getCheckpointInterval() { return this->checkpointInterval; }
+    const string& getLastCheckpoint() { return this->lastCheckpoint; }
+
+    virtual void cancel() { this->cancelled = true; }
+    bool isDone() { return this->cancelled || this->iteration >= this->maxIterations; }
+    int  getIteration() { return this->iteration; }
+    int  getMaxIterations() { return this->maxIterations; }
+    void setMaxIterations(int val) { this->maxIterations = val; }
+    void setSeed(uint64_t seed) { this->rng.seed(seed); }
+
+    // what bounded evaluations saved since init()/resume() (see ProblemData::evaluateBounded())
+    virtual BoundStats getBoundStats() { return this->boundStats; }
+    string getJSONBoundStats() { return this->getBoundStats().getJSON(); }
 protected:
+    virtual void setup() = 0;       // builds the starting state from this->data
+    virtual void iterate() = 0;     // one iteration of the search; this->iteration is already incremented
+    virtual void saveState(SnapshotWriter&) = 0;    // everything iterate() depends on besides the members above
+    virtual void loadState(SnapshotReader&) = 0;    // the reverse of saveState(); this->data is already set
+
+    virtual void setupFrom(const vector<int>&) { this->setup(); }  // warmStart()'s setup(); ignores the solution unless overridden
+
+    // whether a long iteration (or setupFrom()) should wrap up now: the search was cancelled or stepFor()'s budget is spent
+    bool isOutOfTime() { return this->cancelled || chrono::steady_clock::now() >= this->deadline; }
+
+    bool isCheckpointDue() { return this->checkpointInterval > 0 && this->iteration % this->checkpointInterval == 0; }
+    void saveCheckpoint() {
+        this->lastCheckpoint = this->checkpoint();
+        if (this->listener != nullptr) {
+            this->listener->handleCheckpoint(this->lastCheckpoint, this->iteration);
+        }
+    }
+
     ProblemData data;
-    Listener* listener;
+    Listener* listener = nullptr;
     Comparator comparator;
+    int   maxIterations = 0;
+    int   iteration = 0;
+    float elapsed = 0.0;            // wall-clock seconds spent in init() and step() so far
+    Random rng;
+    atomic<bool> cancelled { false };
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();    // set while stepFor() runs
+    int    checkpointInterval = 0;
+    string lastCheckpoint;
+    BoundStats boundStats;
+private:
+    static chrono::steady_clock::duration toDuration(float ms) {
+        return chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<float, milli>(ms));
+    }
+
+    void start(ProblemData data, const vector<int>* facilities) {
+        auto begin = chrono::steady_clock::now();
+        this->data = data;
+        this->comparator.setType(data.type.objective);
+        this->iteration = 0;
+        this->cancelled = false;
+        this->boundStats = BoundStats();
+        if (facilities != nullptr) {
+            this->setupFrom(*facilities);
+        } else {
+            this->setup();
+        }
+        this->elapsed = chrono::duration<float>(chrono::steady_clock::now() - begin).count();
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef ALIASTABLE_H
+#define ALIASTABLE_H
+
+#include <vector>
+#include "Random.h"
+using namespace std;
+
+/**
+ * Walker's alias method (Vose's construction) for drawing an index with probability proportional to its weight
+ *     + build() is O(n), sample() is O(1): one column picked uniformly, then a biased coin between it and its alias
+ *     + negative weights count as 0; if every weight is 0 the draw is uniform
+ * The table is only a snapshot of the weights: rebuild it whenever they change.
+ **/
+class AliasTable {
+public:
+    /**
+     * Rebuilds the table for the given weights
+     *
+     * @param const vector<float>& weights
+     * @return void
+     **/
+    void build(const vector<float>& weights) {
+        int n = weights.size();
+        this->prob.assign(n, 1.0f);
+        this->alias.resize(n);
+        for (int i = 0; i < n; i++) { this->alias[i] = i; }
+
+        double total = 0.0;
+        for (float weight : weights) { total += (weight > 0 ? weight : 0); }
+        if (n == 0 || !(total > 0)) return;
+
+        // scale the weights so they average 1, then pair every column below 1 with one above it
+        vector<double> scaled (n);
+        vector<int> small, large;
+        for (int i = 0; i < n; i++) {
+            scaled[i] = (weights[i] > 0 ? weights[i] : 0) * n / total;
+            (scaled[i] < 1.0 ? small : large).push_back(i);
+        }
+        while (!small.empty() && !large.empty()) {
+            int less = small.back(), more = large.back();
+            small.pop_back();
+            this->prob[less]  = scaled[less];
+            this->alias[less] = more;
+            scaled[more] -= 1.0 - scaled[less];
+            if (scaled[more] < 1.0) {
+                large.pop_back();
+                small.push_back(more);
+            }
+        }
+        // whatever is left is 1 up to rounding, so it keeps its whole column (prob and alias are already set for that)
+    }
+
+    /**
+     * Draws an index
+     *
+     * @preconditions: assumes build() has been given at least one weight
+     * @param Random& rng
+     * @return int
+     **/
+    int sample(Random& rng) const {
+        int i = rng.nextInt(this->prob.size());
+        return (rng.nextFloat() < this->prob[i] ? i : this->alias[i]);
+    }
+
+    int size() const { return this->prob.size(); }
+
+private:
+    vector<float> prob;     // chance of keeping column i rather than taking its alias
+    vector<int>   alias;
+};
+
+#endif
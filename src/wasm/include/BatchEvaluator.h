@@ -0,0 +1,206 @@
+#ifndef BATCHEVALUATOR_H
+#define BATCHEVALUATOR_H
+
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include "defs.h"
+#include "Kernels.h"
+#include "ThreadPool.h"
+#include "ProblemData.h"
+using namespace std;
+
+// customers per block in BatchEvaluator::evaluate(): every facility's slice of its cost row for a block is read from memory once
+// and then stays in cache for every candidate that has that facility open
+const int BATCH_BLOCK = 1024;
+
+/**
+ * Evaluates many open facility sets at once, e.g. every pending candidate of an NDPSO iteration
+ * The candidates go into one flat facility table; evaluate() then walks the customers a block at a time and, within a block,
+ * folds every candidate's facilities into its nearest-facility minimum. Swarm candidates share most of their facilities,
+ * so each cost row is streamed once per iteration instead of once per candidate using it.
+ * Measures are kept per candidate and slot across blocks, so the objectives match ProblemData::evaluate() exactly.
+ *
+ * A candidate can also get a cutoff: on a problem that isBoundable() it's dropped as soon as the customers seen so far prove
+ * it worse than that, like ProblemData::evaluateBounded() (getScanned() then says how far it got)
+ **/
+class BatchEvaluator {
+public:
+    BatchEvaluator() { this->clear(); }
+
+    void clear() {
+        this->table.clear();
+        this->starts.assign(1, 0);
+        this->cutoffs.clear();
+    }
+
+    /**
+     * Queues an open facility set
+     *
+     * @param const vector<int>& facilities (or a pointer to them and their count)
+     * @param int cutoff (INT_MAX for none)
+     * @return int index to read its results back with
+     **/
+    int add(const vector<int>& facilities, int cutoff = INT_MAX) { return this->add(facilities.data(), facilities.size(), cutoff); }
+    int add(const int* facilities, int count, int cutoff = INT_MAX) {
+        this->table.insert(this->table.end(), facilities, facilities + count);
+        this->starts.push_back(this->table.size());
+        this->cutoffs.push_back(cutoff);
+        return this->size() - 1;
+    }
+
+    int size() const { return this->cutoffs.size(); }
+    int getObjective(int i) const { return this->objectives[i]; }
+    int getScanned(int i) const { return this->scanned[i]; }
+    int getCutoff(int i) const { return this->cutoffs[i]; }
+
+    /**
+     * Evaluates every queued facility set
+     * The candidates are split into one contiguous group per thread; implicit problems have no rows to share,
+     * so they're evaluated one candidate at a time instead
+     *
+     * @param const ProblemData& data
+     * @return void
+     **/
+    void evaluate(const ProblemData& data) {
+        int count = this->size();
+        this->objectives.assign(count, 0);
+        this->scanned.assign(count, data.numCustomers);
+        if (data.coordinates) {
+            ThreadPool::getInstance().parallelFor(count, [&](int i) {
+                static thread_local vector<int> facilities;
+                facilities.assign(this->table.begin() + this->starts[i], this->table.begin() + this->starts[i + 1]);
+                this->objectives[i] = data.evaluateBounded(facilities, this->cutoffs[i], nullptr, &this->scanned[i]);
+            });
+            return;
+        }
+
+        // the body only captures two pointers, which function<> holds without allocating
+        ThreadPool::getInstance().parallelFor(this->numGroups(), [this, &data](int group) {
+            this->evaluateGroup(data, group);
+        });
+    }
+
+private:
+    int numGroups() const { return min(this->size(), ThreadPool::getInstance().getNumThreads()); }
+
+    void evaluateGroup(const ProblemData& data, int group) {
+        int count  = this->size();
+        int groups = this->numGroups();
+        int first = (long long) count * group / groups;
+        int last  = (long long) count * (group + 1) / groups;
+        if (data.narrowCosts) {
+            this->evaluateGroup(data, data.narrowCosts->data(), first, last);
+        } else {
+            this->evaluateGroup(data, data.costs->data(), first, last);
+        }
+    }
+
+    template<typename Cost>
+    void evaluateGroup(const ProblemData& data, const Cost* matrix, int first, int last) {
+        static thread_local vector<int> bestCosts, slots, measures, counts;
+        static thread_local vector<long long> totals;
+        static thread_local vector<bool> live;
+        int n = data.numCustomers;
+        int base = this->starts[first];
+        const int* weights = data.demand->data();
+        bool boundable = data.isBoundable();
+        Measure measure = data.type.measure;
+        bool sumOfStars = (measure == STAR && data.type.aggregate == SUM);
+        bool maxRadius  = (measure == RADIUS && data.type.aggregate == MAX);
+
+        bestCosts.resize(BATCH_BLOCK);
+        slots.resize(BATCH_BLOCK);
+        measures.assign(this->starts[last] - base, (measure == RADIUS ? INT_MIN : (measure == RAY ? INT_MAX : 0)));
+        counts.assign(this->starts[last] - base, 0);
+        live.assign(last - first, true);
+        totals.assign(last - first, (maxRadius ? INT_MIN : 0));
+
+        for (int from = 0; from < n; from += BATCH_BLOCK) {
+            int to  = min(n, from + BATCH_BLOCK);
+            int len = to - from;
+            for (int i = first; i < last; i++) {
+                if (!live[i - first]) continue;
+                const int* facilities = this->table.data() + this->starts[i];
+                int p = this->starts[i + 1] - this->starts[i];
+
+                // this block's nearest slot per customer
+                const Cost* row = matrix + facilities[0] * n + from;
+                for (int cust = 0; cust < len; cust++) {
+                    bestCosts[cust] = row[cust];
+                    slots[cust] = 0;
+                }
+                for (int slot = 1; slot < p; slot++) {
+                    Kernels::nearestUpdate(matrix + facilities[slot] * n + from, bestCosts.data(), slots.data(), slot, len);
+                }
+
+                // fold it into the candidate's measures; like evaluate(), the sum of stars and the max radius only need one running value
+                long long& running = totals[i - first];
+                int* candMeasures = measures.data() + this->starts[i] - base;
+                int* candCounts   = counts.data() + this->starts[i] - base;
+                bool exact = (to == n);
+                if (sumOfStars) {
+                    running += Kernels::dot(bestCosts.data(), weights + from, len);
+                } else if (maxRadius) {
+                    running = max(running, (long long) Kernels::max(bestCosts.data(), len));
+                } else {
+                    fold(measure, candMeasures, candCounts, bestCosts.data(), slots.data(), weights + from, len);
+                    if (exact || (boundable && this->cutoffs[i] < INT_MAX)) {
+                        running = aggregate(data.type.aggregate, candMeasures, candCounts, p);
+                    }
+                }
+
+                // the partial objective is a lower bound when boundable (see ProblemData::isBoundable())
+                if (exact) {
+                    this->objectives[i] = Kernels::saturate(running);
+                } else if (boundable && running > this->cutoffs[i]) {
+                    this->objectives[i] = (int) min(running, (long long) INT_MAX);
+                    this->scanned[i] = to;
+                    live[i - first] = false;
+                }
+            }
+        }
+    }
+
+    // adds a block of customers to one candidate's per-slot measures
+    static void fold(Measure measure, int* measures, int* counts, const int* bestCosts, const int* slots, const int* weights, int len) {
+        switch (measure) {
+            case STAR:
+                for (int cust = 0; cust < len; cust++) {
+                    measures[slots[cust]] = Kernels::saturate(measures[slots[cust]] + (long long) weights[cust] * bestCosts[cust]);
+                    counts[slots[cust]]++;
+                }
+                break;
+            case RADIUS:
+                for (int cust = 0; cust < len; cust++) { measures[slots[cust]] = max(measures[slots[cust]], bestCosts[cust]); counts[slots[cust]]++; }
+                break;
+            case RAY:
+                for (int cust = 0; cust < len; cust++) { measures[slots[cust]] = min(measures[slots[cust]], bestCosts[cust]); counts[slots[cust]]++; }
+                break;
+        }
+    }
+
+    // the aggregate of the measures of every slot with customers, without wrapping (the final objective saturates like evaluate()'s)
+    static long long aggregate(Aggregate aggregate, const int* measures, const int* counts, int p) {
+        long long result = (aggregate == MAX ? INT_MIN : (aggregate == MIN ? INT_MAX : 0));
+        for (int slot = 0; slot < p; slot++) {
+            if (counts[slot] == 0) continue;
+            switch (aggregate) {
+                case MAX: result = max(result, (long long) measures[slot]); break;
+                case MIN: result = min(result, (long long) measures[slot]); break;
+                case SUM: result += measures[slot]; break;
+            }
+        }
+        return result;
+    }
+
+    /* members */
+    vector<int> table;          // every candidate's facilities, one after the other
+    vector<int> starts;         // candidate i's facilities are table[starts[i] .. starts[i + 1])
+    vector<int> cutoffs;
+    vector<int> objectives;
+    vector<int> scanned;
+};
+
+#endif
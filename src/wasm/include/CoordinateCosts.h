@@ -0,0 +1,227 @@
+#ifndef COORDINATECOSTS_H
+#define COORDINATECOSTS_H
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "VecOps.h"
+#include "Kernels.h"
+#include "ThreadPool.h"
+using namespace std;
+
+const double EARTH_RADIUS_KM = 6371.0;
+const double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+
+// rows of the distance matrix the mirroring pass in fillMatrix() handles at a time
+const int MIRROR_BLOCK = 64;
+
+/**
+ * How coordinates turn into costs:
+ *     PLANAR:    100 x the straight-line distance in degrees (the original Daskin costs, see Utils::calcCost())
+ *     HAVERSINE: the great-circle distance in whole kilometres, treating x/y as lng/lat on a spherical Earth
+ **/
+enum Metric { PLANAR, HAVERSINE };
+
+/**
+ * Costs of a problem given by node coordinates, computed on demand instead of stored as an n x n matrix
+ * Memory is O(n), which is what lets border/county scale instances (tens of thousands of points) load at all.
+ * PLANAR costs match Utils::calcCost() exactly, so a problem solves the same whichever way its costs are held.
+ * The coordinates are kept structure-of-arrays, so fillRow() computes VecOps::REAL_WIDTH costs at a time,
+ * and fillMatrix() builds a whole dense matrix from the upper triangle across the ThreadPool.
+ *
+ * Nearest-facility queries go through a k-d tree over the open facilities, built per query batch:
+ * O(p log p) to build, then O(log p) per customer on average instead of a scan over all p facilities.
+ * The tree's pruning is only sound for PLANAR costs, so HAVERSINE queries scan every facility's row instead.
+ **/
+struct CoordinateCosts {
+    vector<float> x;    // lng
+    vector<float> y;    // lat
+    Metric metric = PLANAR;
+
+    int size() const { return this->x.size(); }
+
+    /**
+     * Switches the metric; call it again whenever the coordinates change
+     * HAVERSINE precomputes every node's position on the unit sphere, so a cost is a chord length and one asin
+     *
+     * @param Metric metric
+     * @return void
+     **/
+    void setMetric(Metric metric) {
+        this->metric = metric;
+        this->ux.clear();
+        this->uy.clear();
+        this->uz.clear();
+        if (metric == HAVERSINE) {
+            for (int node = 0; node < this->size(); node++) {
+                double lng = this->x[node] * DEGREES_TO_RADIANS;
+                double lat = this->y[node] * DEGREES_TO_RADIANS;
+                this->ux.push_back(cos(lat) * cos(lng));
+                this->uy.push_back(cos(lat) * sin(lng));
+                this->uz.push_back(sin(lat));
+            }
+        }
+    }
+
+    int cost(int a, int b) const {
+        if (this->metric == HAVERSINE) {
+            double dx = this->ux[a] - this->ux[b];
+            double dy = this->uy[a] - this->uy[b];
+            double dz = this->uz[a] - this->uz[b];
+            return arcCost(sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        return (int)(100 * sqrt(pow(this->x[a] - this->x[b], 2.0) + pow(this->y[a] - this->y[b], 2.0)));
+    }
+
+    /**
+     * Computes the costs from a facility to customers [from, size()), VecOps::REAL_WIDTH lanes at a time
+     * Every lane does the same IEEE operations as cost(), so the results are identical to it
+     *
+     * @param int fac
+     * @param int* row: row[cust] is written for every cust >= from
+     * @param int from
+     * @return void
+     **/
+    void fillRow(int fac, int* row, int from = 0) const {
+        int n = this->size();
+        int cust = from;
+        if (this->metric == HAVERSINE) {
+            VecOps::Real fx = VecOps::splatReal(this->ux[fac]);
+            VecOps::Real fy = VecOps::splatReal(this->uy[fac]);
+            VecOps::Real fz = VecOps::splatReal(this->uz[fac]);
+            double chords[VecOps::REAL_WIDTH];
+            for (; cust + VecOps::REAL_WIDTH <= n; cust += VecOps::REAL_WIDTH) {
+                VecOps::Real dx = VecOps::subReal(VecOps::loadReal(&this->ux[cust]), fx);
+                VecOps::Real dy = VecOps::subReal(VecOps::loadReal(&this->uy[cust]), fy);
+                VecOps::Real dz = VecOps::subReal(VecOps::loadReal(&this->uz[cust]), fz);
+                VecOps::Real squared = VecOps::addReal(VecOps::addReal(VecOps::mulReal(dx, dx), VecOps::mulReal(dy, dy)), VecOps::mulReal(dz, dz));
+                VecOps::storeReal(chords, VecOps::sqrtReal(squared));
+                for (int lane = 0; lane < VecOps::REAL_WIDTH; lane++) {
+                    row[cust + lane] = arcCost(chords[lane]);
+                }
+            }
+        } else {
+            float fx = this->x[fac];
+            float fy = this->y[fac];
+            VecOps::Real scale = VecOps::splatReal(100);
+            for (; cust + VecOps::REAL_WIDTH <= n; cust += VecOps::REAL_WIDTH) {
+                VecOps::Real dx = VecOps::widenDiff(&this->x[cust], fx);
+                VecOps::Real dy = VecOps::widenDiff(&this->y[cust], fy);
+                VecOps::Real distance = VecOps::sqrtReal(VecOps::addReal(VecOps::mulReal(dx, dx), VecOps::mulReal(dy, dy)));
+                VecOps::storeTruncated(row + cust, VecOps::mulReal(scale, distance));
+            }
+        }
+        for (; cust < n; cust++) {
+            row[cust] = this->cost(cust, fac);
+        }
+    }
+
+    /**
+     * Fills a dense, facility-major n x n matrix with every cost
+     * Costs are symmetric, so only the upper triangle is computed (one row per task on the ThreadPool);
+     * a second pass mirrors it into the lower triangle a block at a time, to keep the column writes in cache
+     *
+     * @param int* costs: room for size() * size() entries
+     * @return void
+     **/
+    void fillMatrix(int* costs) const {
+        int n = this->size();
+        ThreadPool& pool = ThreadPool::getInstance();
+        pool.parallelFor(n, [&](int fac) {
+            costs[fac * n + fac] = 0;
+            this->fillRow(fac, costs + fac * n, fac + 1);
+        });
+
+        int numBlocks = (n + MIRROR_BLOCK - 1) / MIRROR_BLOCK;
+        pool.parallelFor(numBlocks, [&](int task) {
+            int block = numBlocks - 1 - task;     // the last blocks have the most to copy, so hand them out first
+            int firstRow = block * MIRROR_BLOCK;
+            int lastRow = min(n, firstRow + MIRROR_BLOCK);
+            for (int col = 0; col < lastRow; col++) {
+                for (int row = max(firstRow, col + 1); row < lastRow; row++) {
+                    costs[row * n + col] = costs[col * n + row];
+                }
+            }
+        });
+    }
+
+    /**
+     * Finds every customer's nearest facility
+     * Ties go to the facility that comes first in the facilities vector, as with the cost-matrix kernels
+     *
+     * @param const vector<int>& facilities
+     * @param int* bestCosts: filled with each customer's cost to its nearest facility
+     * @param int* slots: filled with the position of that facility in the facilities vector
+     * @return void
+     **/
+    void nearest(const vector<int>& facilities, int* bestCosts, int* slots) const {
+        static thread_local vector<int> tree, row;
+        int p = facilities.size();
+        if (this->metric != PLANAR) {
+            row.resize(this->size());
+            this->fillRow(facilities[0], bestCosts);
+            fill(slots, slots + this->size(), 0);
+            for (int slot = 1; slot < p; slot++) {
+                this->fillRow(facilities[slot], row.data());
+                Kernels::nearestUpdate(row.data(), bestCosts, slots, slot, this->size());
+            }
+            return;
+        }
+
+        tree.resize(p);
+        for (int slot = 0; slot < p; slot++) {
+            tree[slot] = slot;
+        }
+        this->build(facilities, tree, 0, p, 0);
+
+        for (int cust = 0; cust < this->size(); cust++) {
+            bestCosts[cust] = this->cost(cust, facilities[tree[p / 2]]);
+            slots[cust] = tree[p / 2];
+            this->search(facilities, tree, 0, p, 0, cust, bestCosts[cust], slots[cust]);
+        }
+    }
+private:
+    vector<double> ux, uy, uz;  // unit-sphere positions, only for HAVERSINE
+
+    // great-circle distance in km for a chord of the unit sphere; clamped since rounding can push antipodes past 2
+    static int arcCost(double chord) {
+        return (int)(EARTH_RADIUS_KM * 2 * asin(min(1.0, chord / 2)));
+    }
+
+    // float coordinate of a node along the splitting axis for the given depth
+    float axis(int node, int depth) const { return (depth % 2 == 0 ? this->x[node] : this->y[node]); }
+
+    // arranges tree[lo, hi) so that its middle entry splits the rest by the depth's axis, recursively
+    void build(const vector<int>& facilities, vector<int>& tree, int lo, int hi, int depth) const {
+        if (hi - lo <= 1) return;
+        int mid = (lo + hi) / 2;
+        nth_element(tree.begin() + lo, tree.begin() + mid, tree.begin() + hi, [&](int left, int right) {
+            return this->axis(facilities[left], depth) < this->axis(facilities[right], depth);
+        });
+        this->build(facilities, tree, lo, mid, depth + 1);
+        this->build(facilities, tree, mid + 1, hi, depth + 1);
+    }
+
+    // a subtree is only skipped if even its closest possible point costs strictly more than the best so far,
+    // so equal-cost facilities are still visited and the lowest slot wins
+    void search(const vector<int>& facilities, const vector<int>& tree, int lo, int hi, int depth,
+                int cust, int& bestCost, int& bestSlot) const {
+        if (lo >= hi) return;
+        int mid  = (lo + hi) / 2;
+        int slot = tree[mid];
+        int cost = this->cost(cust, facilities[slot]);
+        if (cost < bestCost || (cost == bestCost && slot < bestSlot)) {
+            bestCost = cost;
+            bestSlot = slot;
+        }
+
+        float diff = this->axis(cust, depth) - this->axis(facilities[slot], depth);
+        bool left = diff < 0;
+        this->search(facilities, tree, (left ? lo : mid + 1), (left ? mid : hi), depth + 1, cust, bestCost, bestSlot);
+        if ((int)(100 * fabs((double)diff)) <= bestCost) {
+            this->search(facilities, tree, (left ? mid + 1 : lo), (left ? hi : mid), depth + 1, cust, bestCost, bestSlot);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef FACILITYSET_H
+#define FACILITYSET_H
+
+#include <vector>
+#include <cstdint>
+#include "Random.h"
+using namespace std;
+
+/**
+ * Which candidate facilities are open, with O(1) membership, O(1) uniform sampling of an open or a closed facility,
+ * and O(1) open/close/swap
+ *     + order is a partition of every candidate: order[0 .. numOpen) are open, the rest closed
+ *     + position[fac] is where fac sits in order, so moving it across the boundary is a single swap
+ *     + bits mirrors open/closed one bit per facility, for membership tests that stay in cache
+ * Shared by NDPSO (Particle) and ALNS (FacRandRepair) instead of rejection sampling against a facilities vector,
+ * which needs O(p) per draw and ever more retries as p approaches the number of candidates.
+ *
+ * clear() undoes the opens since the last clear() in reverse, so the partition goes back to the identity order
+ * and what a draw returns depends only on which facilities are open, never on the set's history.
+ * That keeps runs reproducible across thread counts and checkpoints, even with a per-thread scratch set (forThread()).
+ **/
+class FacilitySet {
+public:
+    FacilitySet() {}
+    FacilitySet(int numCandidates) { this->reset(numCandidates); }
+
+    // a per-thread set over the given number of candidates, for short-lived use (assign() it before drawing)
+    static FacilitySet& forThread(int numCandidates) {
+        static thread_local FacilitySet set;
+        if (set.size() != numCandidates) set.reset(numCandidates);
+        return set;
+    }
+
+    /**
+     * Closes everything, over the given number of candidates
+     *
+     * @param int numCandidates
+     * @return void
+     **/
+    void reset(int numCandidates) {
+        this->order.resize(numCandidates);
+        this->position.resize(numCandidates);
+        for (int fac = 0; fac < numCandidates; fac++) {
+            this->order[fac] = fac;
+            this->position[fac] = fac;
+        }
+        this->bits.assign((numCandidates + 63) / 64, 0);
+        this->count = 0;
+        this->opened.clear();
+        this->undoable = true;
+    }
+
+    // closes everything: O(numOpen) if only open() was used since the last clear(), O(size()) otherwise
+    void clear() {
+        if (!this->undoable) {
+            this->reset(this->size());
+            return;
+        }
+        while (this->count > 0) {
+            this->count--;
+            int fac = this->order[this->count];
+            this->place(fac, this->opened.back());
+            this->opened.pop_back();
+            this->bits[fac >> 6] &= ~(1ULL << (fac & 63));
+        }
+    }
+
+    // opens exactly the given facilities (duplicates are fine)
+    void assign(const vector<int>& facilities) { this->assign(facilities.data(), facilities.size()); }
+    void assign(const int* facilities, int count) {
+        this->clear();
+        for (int i = 0; i < count; i++) {
+            if (!this->isOpen(facilities[i])) this->open(facilities[i]);
+        }
+    }
+
+    int  size() const { return this->order.size(); }
+    int  numOpen() const { return this->count; }
+    int  numClosed() const { return this->size() - this->count; }
+    bool isOpen(int fac) const { return (this->bits[fac >> 6] >> (fac & 63)) & 1; }
+
+    // @preconditions: fac is closed
+    void open(int fac) {
+        this->opened.push_back(this->position[fac]);
+        this->place(fac, this->count);
+        this->count++;
+        this->bits[fac >> 6] |= 1ULL << (fac & 63);
+    }
+
+    // @preconditions: fac is open
+    void close(int fac) {
+        this->count--;
+        this->place(fac, this->count);
+        this->bits[fac >> 6] &= ~(1ULL << (fac & 63));
+        this->undoable = false;
+    }
+
+    // closes one facility and opens another in its place in the partition
+    // @preconditions: closing is open and opening is closed
+    void swap(int closing, int opening) {
+        this->place(opening, this->position[closing]);
+        this->bits[closing >> 6] &= ~(1ULL << (closing & 63));
+        this->bits[opening >> 6] |= 1ULL << (opening & 63);
+        this->undoable = false;
+    }
+
+    // @preconditions: numOpen() > 0
+    int randomOpen(Random& rng) const { return this->order[rng.nextInt(this->count)]; }
+
+    // @preconditions: numClosed() > 0
+    int randomClosed(Random& rng) const { return this->order[this->count + rng.nextInt(this->numClosed())]; }
+
+private:
+    // moves fac to order[index], and whatever was there to fac's old index
+    void place(int fac, int index) {
+        int other = this->order[index];
+        int from  = this->position[fac];
+        this->order[index] = fac;
+        this->order[from]  = other;
+        this->position[fac]   = index;
+        this->position[other] = from;
+    }
+
+    vector<int> order;
+    vector<int> position;
+    vector<uint64_t> bits;
+    vector<int> opened;     // where each open() took its facility from, to undo them in clear()
+    int  count = 0;
+    bool undoable = true;   // false once close()/swap() have been used, since those can't be undone in order
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef FASTINTERCHANGE_H
+#define FASTINTERCHANGE_H
+
+#include <vector>
+#include <climits>
+#include "defs.h"
+#include "ProblemData.h"
+using namespace std;
+
+/**
+ * Whitaker's fast interchange for the p-median objective (the sum of stars, minimized or, with the signs turned around, maximized)
+ * Keeps every customer's nearest and second nearest open facility, and for every slot the loss of closing it:
+ *     loss[slot] = sum over the slot's customers of demand * (second nearest cost - nearest cost)
+ * bestSwap() then scores opening a candidate against closing every slot at once, in one pass over the candidate's cost row:
+ *     + customers the candidate is nearer to than their nearest facility are a gain whatever closes,
+ *       and no longer cost their slot its loss
+ *     + customers it's nearer to than their second nearest cost their slot less to close
+ * so a whole candidate costs O(n + p) instead of p evaluations. swap() only rescans the customers whose nearest or second nearest
+ * facility was the one closed. Which of two equally near facilities counts as the nearest never changes a score.
+ *
+ * Every call must get the same ProblemData (or a copy sharing its buffers) as the reset() the state started from
+ **/
+class FastInterchange {
+public:
+    // whether the problem's objective is the one the gain tables compute
+    static bool supports(const ProblemData& data) {
+        return data.type.aggregate == SUM && data.type.measure == STAR;
+    }
+
+    const vector<int>& getFacilities() const { return this->facilities; }
+    int getObjective() const { return (int) this->objective; }
+
+    /**
+     * Starts over from the given facilities: O(n * p)
+     *
+     * @param const ProblemData& data
+     * @param const vector<int>& facilities
+     * @return void
+     **/
+    void reset(const ProblemData& data, const vector<int>& facilities) {
+        if (data.isImplicit()) {
+            this->reset(data, data.getImplicitCosts(), facilities);
+        } else if (data.isCompact()) {
+            this->reset(data, data.getNarrowCosts(), facilities);
+        } else {
+            this->reset(data, data.getWideCosts(), facilities);
+        }
+    }
+
+    /**
+     * Scores opening fac in place of each open facility and returns the best
+     *
+     * @param const ProblemData& data
+     * @param int fac: a closed candidate
+     * @param int& slot: set to the slot to put it in
+     * @return long long how much the objective would improve by (not positive if no swap with fac improves it)
+     **/
+    long long bestSwap(const ProblemData& data, int fac, int& slot) {
+        long long gain;
+        if (data.isImplicit()) {
+            gain = this->score(data, data.getImplicitCosts().row(fac));
+        } else if (data.isCompact()) {
+            gain = this->score(data, data.getNarrowCosts().row(fac));
+        } else {
+            gain = this->score(data, data.getWideCosts().row(fac));
+        }
+        slot = 0;
+        for (int s = 1; s < (int) this->facilities.size(); s++) {
+            if (this->maximizing ? this->netLoss[s] > this->netLoss[slot] : this->netLoss[s] < this->netLoss[slot]) slot = s;
+        }
+        long long drop = gain - this->netLoss[slot];
+        return (this->maximizing ? -drop : drop);
+    }
+
+    /**
+     * Opens fac in place of the facility in the given slot
+     *
+     * @param const ProblemData& data
+     * @param int slot
+     * @param int fac
+     * @return void
+     **/
+    void swap(const ProblemData& data, int slot, int fac) {
+        if (data.isImplicit()) {
+            this->swap(data, data.getImplicitCosts(), slot, fac);
+        } else if (data.isCompact()) {
+            this->swap(data, data.getNarrowCosts(), slot, fac);
+        } else {
+            this->swap(data, data.getWideCosts(), slot, fac);
+        }
+    }
+
+private:
+    // reset() and swap(), templated on the cost view (see MatrixCosts) so rows are read in place in whatever type they're stored
+    template<typename Costs>
+    void reset(const ProblemData& data, const Costs& costs, const vector<int>& facilities) {
+        int n = data.numCustomers;
+        this->maximizing = (data.type.objective == MAXIMIZE);
+        this->facilities = facilities;
+        this->nearest.assign(n, -1);
+        this->second.assign(n, -1);
+        this->nearestCost.assign(n, INT_MAX);
+        this->secondCost.assign(n, INT_MAX);
+        for (int slot = 0; slot < (int) facilities.size(); slot++) {
+            auto row = costs.row(facilities[slot]);
+            for (int cust = 0; cust < n; cust++) {
+                this->offer(cust, slot, row[cust]);
+            }
+        }
+        this->tally(data);
+    }
+
+    template<typename Costs>
+    void swap(const ProblemData& data, const Costs& costs, int slot, int fac) {
+        int n = data.numCustomers;
+        this->facilities[slot] = fac;
+        auto row = costs.row(fac);
+        for (int cust = 0; cust < n; cust++) {
+            if (this->nearest[cust] == slot || this->second[cust] == slot) {
+                this->rescan(costs, cust);
+            } else {
+                this->offer(cust, slot, row[cust]);
+            }
+        }
+        this->tally(data);
+    }
+
+    // the gain of opening the row's candidate over every customer, leaving what each slot would still lose by closing in netLoss
+    template<typename Cost>
+    long long score(const ProblemData& data, const Cost* row) {
+        int n = data.numCustomers;
+        const int* weights = data.demand->data();
+        this->netLoss = this->loss;
+        long long gain = 0;
+        for (int cust = 0; cust < n; cust++) {
+            int cost = row[cust];
+            if (cost < this->nearestCost[cust]) {
+                gain += (long long) weights[cust] * (this->nearestCost[cust] - cost);
+                this->netLoss[this->nearest[cust]] -= (long long) weights[cust] * ((long long) this->secondCost[cust] - this->nearestCost[cust]);
+            } else if (cost < this->secondCost[cust]) {
+                this->netLoss[this->nearest[cust]] -= (long long) weights[cust] * ((long long) this->secondCost[cust] - cost);
+            }
+        }
+        return gain;
+    }
+
+    // files the slot's cost as the customer's nearest or second nearest if it's nearer than either
+    void offer(int cust, int slot, int cost) {
+        if (cost < this->nearestCost[cust]) {
+            this->second[cust] = this->nearest[cust];
+            this->secondCost[cust] = this->nearestCost[cust];
+            this->nearest[cust] = slot;
+            this->nearestCost[cust] = cost;
+        } else if (cost < this->secondCost[cust]) {
+            this->second[cust] = slot;
+            this->secondCost[cust] = cost;
+        }
+    }
+
+    template<typename Costs>
+    void rescan(const Costs& costs, int cust) {
+        this->nearest[cust] = this->second[cust] = -1;
+        this->nearestCost[cust] = this->secondCost[cust] = INT_MAX;
+        for (int slot = 0; slot < (int) this->facilities.size(); slot++) {
+            this->offer(cust, slot, costs.cost(cust, this->facilities[slot]));
+        }
+    }
+
+    // the objective and every slot's loss, from the nearest costs (a customer without a second nearest is only possible at p = 1,
+    // where its loss is effectively infinite and score() takes all of it back)
+    void tally(const ProblemData& data) {
+        const int* weights = data.demand->data();
+        this->loss.assign(this->facilities.size(), 0);
+        this->objective = 0;
+        for (int cust = 0; cust < data.numCustomers; cust++) {
+            this->objective += (long long) weights[cust] * this->nearestCost[cust];
+            this->loss[this->nearest[cust]] += (long long) weights[cust] * ((long long) this->secondCost[cust] - this->nearestCost[cust]);
+        }
+    }
+
+    vector<int> facilities;         // by slot
+    vector<int> nearest, second;    // slots, per customer
+    vector<int> nearestCost, secondCost;
+    vector<long long> loss;         // per slot
+    vector<long long> netLoss;      // score()'s scratch
+    long long objective = 0;
+    bool maximizing = false;
+};
+
+#endif
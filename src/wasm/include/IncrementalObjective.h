@@ -0,0 +1,431 @@
+#ifndef INCREMENTALOBJECTIVE_H
+#define INCREMENTALOBJECTIVE_H
+
+#include <vector>
+#include <climits>
+#include "defs.h"
+#include "ProblemData.h"
+using namespace std;
+
+// below this many open facilities a full ProblemData::evaluate() streams the few cost rows faster than a move updates the state
+const int INCREMENTAL_MIN_FACILITIES = 40;
+
+/**
+ * A tournament tree over facility slots: every inner node holds the aggregate (max, min or sum) of its two children,
+ * so the root is the objective and changing one slot's measure costs O(log p)
+ * Slots without customers hold the aggregate's identity, like ProblemData::evaluate() gives them
+ * Nodes are long long, so a sum of stars can outgrow an int on the way up and only the root saturates (see Kernels::saturate())
+ **/
+class MeasureTree {
+public:
+    /**
+     * Sizes the tree for the given number of slots and empties every leaf
+     *
+     * @param int size
+     * @param Aggregate aggregate
+     * @return void
+     **/
+    void reset(int size, Aggregate aggregate) {
+        this->aggregate = aggregate;
+        this->empty = (aggregate == MAX ? INT_MIN : (aggregate == MIN ? INT_MAX : 0));
+        this->width = 1;
+        while (this->width < size) this->width <<= 1;
+        this->nodes.assign(2 * this->width, this->empty);
+    }
+
+    int getEmpty() const { return this->empty; }
+    int top() const { return Kernels::saturate(this->nodes[1]); }
+
+    // sets a leaf without touching its ancestors; call rebuild() once every leaf is in
+    void setLeaf(int slot, long long value) { this->nodes[this->width + slot] = value; }
+
+    void rebuild() {
+        for (int node = this->width - 1; node > 0; node--) {
+            this->nodes[node] = this->combine(this->nodes[2 * node], this->nodes[2 * node + 1]);
+        }
+    }
+
+    // sets a leaf and walks up to the root: O(log p)
+    void set(int slot, long long value) {
+        int node = this->width + slot;
+        this->nodes[node] = value;
+        for (node >>= 1; node > 0; node >>= 1) {
+            this->nodes[node] = this->combine(this->nodes[2 * node], this->nodes[2 * node + 1]);
+        }
+    }
+
+private:
+    long long combine(long long left, long long right) const {
+        switch (this->aggregate) {
+            case MAX: return max(left, right);
+            case MIN: return min(left, right);
+            default:  return left + right;
+        }
+    }
+
+    vector<long long> nodes;    // nodes[1] is the root, the leaves are nodes[width .. width + size)
+    int width = 1;
+    int empty = 0;
+    Aggregate aggregate = SUM;
+};
+
+/**
+ * The customer assignments, per-facility measures and objective of one open facility set, kept up to date move by move
+ *     + replace() exchanges the facility in one slot (NDPSO's move)
+ *     + remove() and add() erase slots and append facilities (ALNS's destroy and repair), and follow() works out which to call
+ * A move only rescans the customers that lost their facility, compares the rest against the new facility's cost row,
+ * and touches the measures of the slots customers moved between, so it costs O(n) instead of evaluate()'s O(n * p).
+ * Ties go to the earlier slot, exactly as in ProblemData::evaluate(), so getObjective() always equals evaluate(getFacilities())
+ *
+ * Every call must get the same ProblemData (or a copy sharing its buffers) as the reset() the state started from
+ **/
+class IncrementalObjective {
+public:
+    const vector<int>& getFacilities() const { return this->facilities; }
+    int getObjective() const { return this->tree.top(); }
+    // how many times the state started over with a full evaluation (every reset(), including those follow() fell back to)
+    long long getResets() const { return this->resets; }
+
+    /**
+     * Starts over from scratch on the given facilities: one full evaluation
+     *
+     * @param const ProblemData& data
+     * @param const vector<int>& facilities
+     * @return void
+     **/
+    void reset(const ProblemData& data, const vector<int>& facilities) {
+        int n = data.numCustomers;
+        int p = facilities.size();
+        const int* weights = data.demand->data();
+        this->resets++;
+        this->measure = data.type.measure;
+        this->facilities = facilities;
+        this->bestCosts.resize(n);
+        this->slots.resize(n);
+        data.nearest(facilities, this->bestCosts.data(), this->slots.data());
+
+        this->counts.assign(p, 0);
+        this->measures.assign(p, 0);
+        for (int cust = 0; cust < n; cust++) {
+            this->join(this->slots[cust], this->bestCosts[cust], weights[cust]);
+        }
+        this->tree.reset(p, data.type.aggregate);
+        for (int slot = 0; slot < p; slot++) {
+            this->tree.setLeaf(slot, this->leaf(slot));
+        }
+        this->tree.rebuild();
+    }
+
+    /**
+     * Opens fac in place of whatever facility is in the given slot
+     *
+     * @param const ProblemData& data
+     * @param int slot
+     * @param int fac
+     * @return void
+     **/
+    void replace(const ProblemData& data, int slot, int fac) {
+        if (data.isImplicit()) {
+            this->replace(data, data.getImplicitCosts(), slot, fac);
+        } else if (data.isCompact()) {
+            this->replace(data, data.getNarrowCosts(), slot, fac);
+        } else {
+            this->replace(data, data.getWideCosts(), slot, fac);
+        }
+    }
+
+    /**
+     * Erases the given slots; the facilities after them shift down, keeping their order
+     *
+     * @param const ProblemData& data
+     * @param const vector<int>& removed: slots to erase, each at most once
+     * @return void
+     **/
+    void remove(const ProblemData& data, const vector<int>& removed) {
+        if (data.isImplicit()) {
+            this->remove(data, data.getImplicitCosts(), removed);
+        } else if (data.isCompact()) {
+            this->remove(data, data.getNarrowCosts(), removed);
+        } else {
+            this->remove(data, data.getWideCosts(), removed);
+        }
+    }
+
+    /**
+     * Opens fac in a new slot after every other
+     *
+     * @param const ProblemData& data
+     * @param int fac
+     * @return void
+     **/
+    void add(const ProblemData& data, int fac) {
+        if (data.isImplicit()) {
+            this->add(data, data.getImplicitCosts(), fac);
+        } else if (data.isCompact()) {
+            this->add(data, data.getNarrowCosts(), fac);
+        } else {
+            this->add(data, data.getWideCosts(), fac);
+        }
+    }
+
+    /**
+     * Catches up with a facilities vector that was edited since the last call (e.g. by an ALNS destroy and repair)
+     * Finds the slots that were erased and the facilities appended after the rest and applies just those,
+     * or starts over with reset() when that wouldn't be any cheaper
+     *
+     * @param const ProblemData& data
+     * @param const vector<int>& facilities
+     * @return void
+     **/
+    void follow(const ProblemData& data, const vector<int>& facilities) {
+        static thread_local vector<int> removed;
+        int p = this->facilities.size();
+        if (p < INCREMENTAL_MIN_FACILITIES || (int) this->slots.size() != data.numCustomers || this->measure != data.type.measure) {
+            this->reset(data, facilities);
+            return;
+        }
+
+        // every facility still there has to come in the same order, and anything new has to come after them
+        removed.clear();
+        int kept = 0;
+        for (int slot = 0; slot < p; slot++) {
+            if (kept < (int) facilities.size() && facilities[kept] == this->facilities[slot]) {
+                kept++;
+            } else {
+                removed.push_back(slot);
+            }
+        }
+        int added = facilities.size() - kept;
+        if (2 * ((int) removed.size() + added) > p || kept == 0) {
+            this->reset(data, facilities);
+            return;
+        }
+        if (!removed.empty()) {
+            this->remove(data, removed);
+        }
+        for (int i = kept; i < (int) facilities.size(); i++) {
+            this->add(data, facilities[i]);
+        }
+    }
+
+    /**
+     * Writes the facility assigned to each customer
+     *
+     * @param vector<int>& assignments
+     * @return void
+     **/
+    void getAssignments(vector<int>& assignments) const {
+        int n = this->slots.size();
+        assignments.resize(n);
+        for (int cust = 0; cust < n; cust++) {
+            assignments[cust] = this->facilities[this->slots[cust]];
+        }
+    }
+
+    /**
+     * The measure of every facility that has customers, as (facility, measure) pairs in slot order
+     *
+     * @return vector<pair<int, int>>
+     **/
+    vector<pair<int, int>> getMeasures() const {
+        vector<pair<int, int>> pairs;
+        for (int slot = 0; slot < (int) this->facilities.size(); slot++) {
+            if (this->counts[slot] > 0) pairs.push_back({ this->facilities[slot], Kernels::saturate(this->measures[slot]) });
+        }
+        return pairs;
+    }
+
+private:
+    // the moves, templated on the cost view (see MatrixCosts) so a row is read in place in whatever type it's stored
+    template<typename Costs>
+    void replace(const ProblemData& data, const Costs& costs, int slot, int fac) {
+        int n = data.numCustomers;
+        const int* weights = data.demand->data();
+        this->facilities[slot] = fac;
+        auto row = costs.row(fac);
+
+        // the slot's old customers all leave it, so its measure starts over
+        this->counts[slot] = 0;
+        this->measures[slot] = 0;
+        this->beginMove();
+        this->touch(slot);
+        for (int cust = 0; cust < n; cust++) {
+            int from = this->slots[cust];
+            int cost = row[cust];
+            if (from == slot) {
+                this->rescan(costs, cust, slot, cost, weights[cust]);
+            } else if (cost < this->bestCosts[cust] || (cost == this->bestCosts[cust] && slot < from)) {
+                this->leave(from, this->bestCosts[cust], weights[cust]);
+                this->move(cust, slot, cost, weights[cust]);
+            }
+        }
+        this->endMove(data);
+    }
+
+    template<typename Costs>
+    void remove(const ProblemData& data, const Costs& costs, const vector<int>& removed) {
+        static thread_local vector<int> newSlot;
+        int n = data.numCustomers;
+        int p = this->facilities.size();
+        const int* weights = data.demand->data();
+
+        newSlot.assign(p, 0);
+        for (int slot : removed) newSlot[slot] = -1;
+        int kept = 0;
+        for (int slot = 0; slot < p; slot++) {
+            if (newSlot[slot] < 0) continue;
+            newSlot[slot] = kept;
+            this->facilities[kept] = this->facilities[slot];
+            this->measures[kept]   = this->measures[slot];
+            this->counts[kept]     = this->counts[slot];
+            kept++;
+        }
+        this->facilities.resize(kept);
+        this->measures.resize(kept);
+        this->counts.resize(kept);
+
+        // customers of the erased facilities only ever join kept ones, so no measure needs recalculating
+        this->beginMove();
+        for (int cust = 0; cust < n; cust++) {
+            int slot = newSlot[this->slots[cust]];
+            if (slot >= 0) {
+                this->slots[cust] = slot;
+            } else {
+                this->rescan(costs, cust, -1, 0, weights[cust]);
+            }
+        }
+        this->rebuildTree(data.type.aggregate);
+    }
+
+    template<typename Costs>
+    void add(const ProblemData& data, const Costs& costs, int fac) {
+        int n = data.numCustomers;
+        int slot = this->facilities.size();
+        const int* weights = data.demand->data();
+        auto row = costs.row(fac);
+        this->facilities.push_back(fac);
+        this->measures.push_back(0);
+        this->counts.push_back(0);
+
+        // the new slot comes last, so it only wins customers it's strictly cheaper for
+        this->beginMove();
+        for (int cust = 0; cust < n; cust++) {
+            if (row[cust] < this->bestCosts[cust]) {
+                this->leave(this->slots[cust], this->bestCosts[cust], weights[cust]);
+                this->move(cust, slot, row[cust], weights[cust]);
+            }
+        }
+        this->recalculateDirty(data);
+        this->rebuildTree(data.type.aggregate);
+    }
+
+    // finds a customer's nearest facility over every slot, trying the given slot's cost (if any) without looking it up
+    template<typename Costs>
+    void rescan(const Costs& costs, int cust, int knownSlot, int knownCost, int weight) {
+        int bestSlot = -1, best = 0;
+        for (int slot = 0; slot < (int) this->facilities.size(); slot++) {
+            int cost = (slot == knownSlot ? knownCost : costs.cost(cust, this->facilities[slot]));
+            if (bestSlot < 0 || cost < best) {
+                best = cost;
+                bestSlot = slot;
+            }
+        }
+        this->move(cust, bestSlot, best, weight);
+    }
+
+    void move(int cust, int slot, int cost, int weight) {
+        this->slots[cust] = slot;
+        this->bestCosts[cust] = cost;
+        this->join(slot, cost, weight);
+        this->touch(slot);
+    }
+
+    void join(int slot, int cost, int weight) {
+        switch (this->measure) {
+            case STAR:
+                this->measures[slot] += (long long) weight * cost;
+                break;
+            case RADIUS:
+                this->measures[slot] = (this->counts[slot] == 0 ? cost : max(this->measures[slot], (long long) cost));
+                break;
+            case RAY:
+                this->measures[slot] = (this->counts[slot] == 0 ? cost : min(this->measures[slot], (long long) cost));
+                break;
+        }
+        this->counts[slot]++;
+    }
+
+    // a star just loses the customer's share; a radius or ray the customer defined has to be recalculated after the move
+    void leave(int slot, int cost, int weight) {
+        this->counts[slot]--;
+        if (this->measure == STAR) {
+            this->measures[slot] -= (long long) weight * cost;
+        } else if (cost == this->measures[slot] && !this->dirty[slot]) {
+            this->dirty[slot] = true;
+            this->dirtySlots.push_back(slot);
+        }
+        this->touch(slot);
+    }
+
+    void touch(int slot) {
+        if (!this->touched[slot]) {
+            this->touched[slot] = true;
+            this->touchedSlots.push_back(slot);
+        }
+    }
+
+    void beginMove() {
+        int p = this->facilities.size();
+        this->touched.assign(p, false);
+        this->dirty.assign(p, false);
+        this->touchedSlots.clear();
+        this->dirtySlots.clear();
+    }
+
+    // one pass over the customers recalculates every radius/ray a leaving customer may have defined
+    void recalculateDirty(const ProblemData& data) {
+        if (this->dirtySlots.empty()) return;
+        for (int slot : this->dirtySlots) {
+            this->counts[slot] = 0;
+        }
+        for (int cust = 0; cust < data.numCustomers; cust++) {
+            int slot = this->slots[cust];
+            if (this->dirty[slot]) this->join(slot, this->bestCosts[cust], 1);
+        }
+    }
+
+    // only the slots customers moved between change, so only their leaves are walked up
+    void endMove(const ProblemData& data) {
+        this->recalculateDirty(data);
+        for (int slot : this->touchedSlots) {
+            this->tree.set(slot, this->leaf(slot));
+        }
+    }
+
+    void rebuildTree(Aggregate aggregate) {
+        int p = this->facilities.size();
+        this->tree.reset(p, aggregate);
+        for (int slot = 0; slot < p; slot++) {
+            this->tree.setLeaf(slot, this->leaf(slot));
+        }
+        this->tree.rebuild();
+    }
+
+    long long leaf(int slot) const { return (this->counts[slot] > 0 ? this->measures[slot] : this->tree.getEmpty()); }
+
+    /* members */
+    Measure measure = STAR;
+    long long resets = 0;
+    vector<int> facilities;     // open facility per slot
+    vector<int> slots;          // per customer: slot of its nearest facility
+    vector<int> bestCosts;      // per customer: cost to that facility
+    vector<long long> measures; // per slot: star, radius or ray (only meaningful while counts[slot] > 0), unsaturated
+    vector<int> counts;         // per slot: number of customers
+    MeasureTree tree;
+
+    // bookkeeping for the move in progress
+    vector<bool> touched, dirty;
+    vector<int>  touchedSlots, dirtySlots;
+};
+
+#endif
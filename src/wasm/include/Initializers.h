@@ -0,0 +1,372 @@
+#ifndef INITIALIZERS_H
+#define INITIALIZERS_H
+
+#include <cmath>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include "defs.h"
+#include "Random.h"
+#include "Kernels.h"
+#include "Comparator.h"
+#include "FacilitySet.h"
+#include "ProblemData.h"
+using namespace std;
+
+// stochastic greedy: each step of greedyAdd() tries (numCandidates / numFacilities) * ln(1 / GREEDY_EPSILON) sampled candidates,
+// which keeps it within (1 - 1/e - GREEDY_EPSILON) of the full greedy's gain in expectation, but never more than GREEDY_MAX_SAMPLES
+// (on usaborder10 at p = 10, 128 samples start ALNS as well as the full ~2500 do, in a twentieth of the time)
+const float GREEDY_EPSILON = 0.01;
+const int   GREEDY_MAX_SAMPLES = 128;
+
+// constructions AUTO_INIT tries, keeping the best
+const int INIT_RESTARTS = 8;
+
+// how a starting solution is built (see Initializers::construct())
+enum InitStrategy {
+    AUTO_INIT,          // the best of a few constructions picked from the problem type (see Initializers::construct())
+    GREEDY_ADD,
+    GREEDY_DROP,
+    KMEANS_PLUS_PLUS,
+    FARTHEST_POINT,
+    RANDOM_INIT,
+    SWARM_INIT          // a very short NDPSO run; only ALNS knows how to do this one
+};
+
+/**
+ * Constructive heuristics that open numFacilities facilities in roughly one pass over the cost matrix or less,
+ * instead of searching for a starting point. All of them draw only from the given generator.
+ * The greedy ones score facilities by the demand-weighted sum of nearest costs (the p-median objective), whatever the problem type;
+ * that's the usual surrogate, and pick() only uses them where it fits.
+ **/
+namespace Initializers {
+
+    /**
+     * Which heuristic suits the given problem best
+     *     + minimizing stars: greedy add (the p-median greedy)
+     *     + minimizing radii: farthest point (the 2-approximation for the p-center problem)
+     *     + minimizing rays: k-means++ (spread out, weighted by demand)
+     *     + maximizing: random, since every constructive heuristic here pulls toward the customers
+     *
+     * @param const ProblemData& data
+     * @return InitStrategy
+     **/
+    inline InitStrategy pick(const ProblemData& data) {
+        if (data.type.objective == MAXIMIZE) return RANDOM_INIT;
+        switch (data.type.measure) {
+            case STAR:   return GREEDY_ADD;
+            case RADIUS: return FARTHEST_POINT;
+            default:     return KMEANS_PLUS_PLUS;
+        }
+    }
+
+    // the closed candidate cheapest to the given customer (O(numCandidates))
+    inline int nearestClosed(const ProblemData& data, const FacilitySet& open, int cust) {
+        int best = -1, bestCost = INT_MAX;
+        for (int fac = 0; fac < data.numCandidates; fac++) {
+            if (open.isOpen(fac)) continue;
+            int cost = data.getCost(cust, fac);
+            if (best == -1 || cost < bestCost) {
+                best = fac;
+                bestCost = cost;
+            }
+        }
+        return best;
+    }
+
+    // opens fac and folds its costs into the nearest costs, reading its row through the given cost view (see MatrixCosts)
+    template<typename Costs>
+    inline void openFacility(const ProblemData& data, const Costs& costs, FacilitySet& open, vector<int>& facilities, vector<int>& bestCosts, int fac) {
+        auto row = costs.row(fac);
+        for (int cust = 0; cust < data.numCustomers; cust++) {
+            bestCosts[cust] = min(bestCosts[cust], (int) row[cust]);
+        }
+        open.open(fac);
+        facilities.push_back(fac);
+    }
+
+    inline void openFacility(const ProblemData& data, FacilitySet& open, vector<int>& facilities, vector<int>& bestCosts, int fac) {
+        if (data.isImplicit()) {
+            openFacility(data, data.getImplicitCosts(), open, facilities, bestCosts, fac);
+        } else if (data.isCompact()) {
+            openFacility(data, data.getNarrowCosts(), open, facilities, bestCosts, fac);
+        } else {
+            openFacility(data, data.getWideCosts(), open, facilities, bestCosts, fac);
+        }
+    }
+
+    /**
+     * Opens count facilities at random
+     *
+     * @param const ProblemData& data
+     * @param Random& rng
+     * @param int count
+     * @return vector<int> facilities
+     **/
+    inline vector<int> randomFacilities(const ProblemData& data, Random& rng, int count) {
+        FacilitySet open (data.numCandidates);
+        vector<int> facilities;
+        for (int i = 0; i < count; i++) {
+            int fac = open.randomClosed(rng);
+            open.open(fac);
+            facilities.push_back(fac);
+        }
+        return facilities;
+    }
+
+    /**
+     * k-means++ seeding on the costs: each step draws a customer with probability proportional to demand * (cost to its nearest open facility)^2
+     * and opens the candidate nearest to it; the first draw is proportional to demand alone
+     * O(count * (numCustomers + numCandidates))
+     *
+     * @param const ProblemData& data
+     * @param Random& rng
+     * @param int count
+     * @return vector<int> facilities
+     **/
+    inline vector<int> kMeansPlusPlus(const ProblemData& data, Random& rng, int count) {
+        int n = data.numCustomers;
+        const int* weights = data.demand->data();
+        FacilitySet open (data.numCandidates);
+        vector<int> facilities;
+        vector<int> bestCosts (n, INT_MAX);
+        vector<double> cumulative (n);
+
+        for (int i = 0; i < count; i++) {
+            double total = 0.0;
+            for (int cust = 0; cust < n; cust++) {
+                double cost = (i == 0 ? 1.0 : (double) bestCosts[cust]);
+                total += weights[cust] * cost * cost;
+                cumulative[cust] = total;
+            }
+
+            int fac;
+            if (total > 0.0) {
+                double target = rng.nextFloat() * total;
+                int cust = upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+                fac = nearestClosed(data, open, min(cust, n - 1));
+            } else {
+                fac = open.randomClosed(rng);   // every customer is already served at no cost
+            }
+            openFacility(data, open, facilities, bestCosts, fac);
+        }
+        return facilities;
+    }
+
+    /**
+     * Farthest-point (Gonzalez) heuristic: starts next to a random customer, then repeatedly opens the candidate nearest to
+     * the customer farthest from every open facility. Demand is ignored, like it is by RADIUS
+     * O(count * (numCustomers + numCandidates))
+     *
+     * @param const ProblemData& data
+     * @param Random& rng
+     * @param int count
+     * @return vector<int> facilities
+     **/
+    inline vector<int> farthestPoint(const ProblemData& data, Random& rng, int count) {
+        int n = data.numCustomers;
+        FacilitySet open (data.numCandidates);
+        vector<int> facilities;
+        vector<int> bestCosts (n, INT_MAX);
+
+        int cust = rng.nextInt(n);
+        for (int i = 0; i < count; i++) {
+            int fac = (i == 0 || bestCosts[cust] > 0 ? nearestClosed(data, open, cust) : open.randomClosed(rng));
+            openFacility(data, open, facilities, bestCosts, fac);
+            cust = max_element(bestCosts.begin(), bestCosts.end()) - bestCosts.begin();
+        }
+        return facilities;
+    }
+
+    /**
+     * Opens count more facilities by stochastic greedy, on top of the ones already open
+     * bestCosts holds every customer's cost to its nearest open facility (INT_MAX if none) and is kept up to date,
+     * so a step scores each of its sampled candidates in one pass over the candidate's row, against the same array,
+     * and the open facilities never have to be evaluated again
+     * Templated on the cost view, so the rows are read in place (see MatrixCosts); the overload without one picks it from the problem
+     *
+     * @param const ProblemData& data
+     * @param const Costs& costs
+     * @param Random& rng
+     * @param FacilitySet& open
+     * @param vector<int>& facilities: the new facilities are appended
+     * @param vector<int>& bestCosts
+     * @param int count
+     * @return int number of candidates scored
+     **/
+    template<typename Costs>
+    inline int greedyExtend(const ProblemData& data, const Costs& costs, Random& rng, FacilitySet& open, vector<int>& facilities, vector<int>& bestCosts, int count) {
+        int n = data.numCustomers;
+        const int* weights = data.demand->data();
+        int samples = (int) ceil((double) data.numCandidates / max(count, 1) * log(1.0 / GREEDY_EPSILON));
+        samples = min(samples, GREEDY_MAX_SAMPLES);
+        int scored = 0;
+
+        for (int i = 0; i < count; i++) {
+            int best = -1;
+            long long bestTotal = 0;
+            for (int k = 0; k < min(samples, open.numClosed()); k++) {
+                int fac = open.randomClosed(rng);
+                long long total = Kernels::dotMin(costs.row(fac), bestCosts.data(), weights, n);
+                if (best == -1 || total < bestTotal) {
+                    best = fac;
+                    bestTotal = total;
+                }
+                scored++;
+            }
+            openFacility(data, costs, open, facilities, bestCosts, best);
+        }
+        return scored;
+    }
+
+    inline int greedyExtend(const ProblemData& data, Random& rng, FacilitySet& open, vector<int>& facilities, vector<int>& bestCosts, int count) {
+        if (data.isImplicit()) {
+            return greedyExtend(data, data.getImplicitCosts(), rng, open, facilities, bestCosts, count);
+        } else if (data.isCompact()) {
+            return greedyExtend(data, data.getNarrowCosts(), rng, open, facilities, bestCosts, count);
+        }
+        return greedyExtend(data, data.getWideCosts(), rng, open, facilities, bestCosts, count);
+    }
+
+    /**
+     * Greedy add: each step opens whichever of a random sample of closed candidates lowers the weighted sum of nearest costs the most
+     * (stochastic greedy, see GREEDY_EPSILON); each sampled candidate costs one pass over its row
+     * O(numCandidates * ln(1 / GREEDY_EPSILON) * numCustomers) overall, whatever the count
+     *
+     * @param const ProblemData& data
+     * @param Random& rng
+     * @param int count
+     * @return vector<int> facilities
+     **/
+    inline vector<int> greedyAdd(const ProblemData& data, Random& rng, int count) {
+        FacilitySet open (data.numCandidates);
+        vector<int> facilities;
+        vector<int> bestCosts (data.numCustomers, INT_MAX);
+        greedyExtend(data, rng, open, facilities, bestCosts, count);
+        return facilities;
+    }
+
+    /**
+     * Greedy drop: starts from twice as many facilities as needed (k-means++ seeded) and keeps closing whichever facility's customers
+     * lose the least by moving to their second nearest, until count are left
+     * Only the customers whose nearest or second nearest facility closed are rescanned, so each drop is about O(numCustomers)
+     * Templated on the cost view like greedyExtend()
+     *
+     * @param const ProblemData& data
+     * @param const Costs& costs
+     * @param Random& rng
+     * @param int count
+     * @return vector<int> facilities
+     **/
+    template<typename Costs>
+    inline vector<int> greedyDrop(const ProblemData& data, const Costs& costs, Random& rng, int count) {
+        int n = data.numCustomers;
+        const int* weights = data.demand->data();
+        vector<int> facilities = kMeansPlusPlus(data, rng, min(data.numCandidates, 2 * count));
+        int k = facilities.size();
+        if (k <= count) return facilities;
+
+        // nearest and second nearest slot per customer, and what closing each slot would cost
+        vector<int> first (n, -1), second (n, -1), firstCost (n, INT_MAX), secondCost (n, INT_MAX);
+        for (int slot = 0; slot < k; slot++) {
+            auto row = costs.row(facilities[slot]);
+            for (int cust = 0; cust < n; cust++) {
+                if (row[cust] < firstCost[cust]) {
+                    second[cust] = first[cust];  secondCost[cust] = firstCost[cust];
+                    first[cust]  = slot;         firstCost[cust]  = row[cust];
+                } else if (row[cust] < secondCost[cust]) {
+                    second[cust] = slot;         secondCost[cust] = row[cust];
+                }
+            }
+        }
+        vector<long long> loss (k, 0);
+        for (int cust = 0; cust < n; cust++) {
+            loss[first[cust]] += (long long) weights[cust] * (secondCost[cust] - firstCost[cust]);
+        }
+
+        vector<bool> closed (k, false);
+        for (int open = k; open > count; open--) {
+            int drop = -1;
+            for (int slot = 0; slot < k; slot++) {
+                if (!closed[slot] && (drop == -1 || loss[slot] < loss[drop])) drop = slot;
+            }
+            closed[drop] = true;
+
+            for (int cust = 0; cust < n; cust++) {
+                if (first[cust] != drop && second[cust] != drop) continue;
+                if (first[cust] != drop) loss[first[cust]] -= (long long) weights[cust] * (secondCost[cust] - firstCost[cust]);
+                first[cust] = second[cust] = -1;
+                firstCost[cust] = secondCost[cust] = INT_MAX;
+                for (int slot = 0; slot < k; slot++) {
+                    if (closed[slot]) continue;
+                    int cost = costs.cost(cust, facilities[slot]);
+                    if (cost < firstCost[cust]) {
+                        second[cust] = first[cust];  secondCost[cust] = firstCost[cust];
+                        first[cust]  = slot;         firstCost[cust]  = cost;
+                    } else if (cost < secondCost[cust]) {
+                        second[cust] = slot;         secondCost[cust] = cost;
+                    }
+                }
+                if (second[cust] != -1) loss[first[cust]] += (long long) weights[cust] * (secondCost[cust] - firstCost[cust]);
+            }
+        }
+
+        vector<int> kept;
+        for (int slot = 0; slot < k; slot++) {
+            if (!closed[slot]) kept.push_back(facilities[slot]);
+        }
+        return kept;
+    }
+
+    inline vector<int> greedyDrop(const ProblemData& data, Random& rng, int count) {
+        if (data.isImplicit()) {
+            return greedyDrop(data, data.getImplicitCosts(), rng, count);
+        } else if (data.isCompact()) {
+            return greedyDrop(data, data.getNarrowCosts(), rng, count);
+        }
+        return greedyDrop(data, data.getWideCosts(), rng, count);
+    }
+
+    /**
+     * Opens data.numFacilities facilities with the given strategy
+     * AUTO_INIT alternates between pick()'s heuristic and greedy drop for INIT_RESTARTS constructions and keeps the best
+     * (neither wins everywhere: drop does better on few facilities per candidate, add and farthest point on many)
+     *
+     * @param InitStrategy strategy (not SWARM_INIT)
+     * @param const ProblemData& data
+     * @param Random& rng
+     * @return vector<int> facilities
+     **/
+    inline vector<int> construct(InitStrategy strategy, const ProblemData& data, Random& rng) {
+        int count = data.numFacilities;
+        if (strategy == AUTO_INIT) {
+            InitStrategy first = pick(data);
+            if (first == RANDOM_INIT) return randomFacilities(data, rng, count);
+
+            Comparator comparator (data.type.objective);
+            vector<int> best;
+            int bestObjective = 0;
+            for (int i = 0; i < INIT_RESTARTS; i++) {
+                vector<int> facilities = construct(i % 2 == 0 ? first : GREEDY_DROP, data, rng);
+                int objective = data.evaluate(facilities);
+                if (best.empty() || comparator(objective, bestObjective)) {
+                    best = facilities;
+                    bestObjective = objective;
+                }
+            }
+            return best;
+        }
+
+        switch (strategy) {
+            case GREEDY_ADD:       return greedyAdd(data, rng, count);
+            case GREEDY_DROP:      return greedyDrop(data, rng, count);
+            case KMEANS_PLUS_PLUS: return kMeansPlusPlus(data, rng, count);
+            case FARTHEST_POINT:   return farthestPoint(data, rng, count);
+            case RANDOM_INIT:      return randomFacilities(data, rng, count);
+            default:
+                throw "Initializers::construct(): unrecognized strategy!";
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,316 @@
+#include "IslandNDPSO.h"
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include "NDPSO.h"
+#include "ThreadPool.h"
+using namespace std;
+
+/**
+ * Default constructor
+ * Uses ISLAND_COUNT islands of ISLAND_SWARM_SIZE particles on a ring
+ **/
+IslandNDPSO::IslandNDPSO() : IslandNDPSO(ISLAND_COUNT) {}
+
+/**
+ * Constructor for setting the number of islands
+ *
+ * @param int numIslands
+ **/
+IslandNDPSO::IslandNDPSO(int numIslands) : IslandNDPSO(numIslands, ISLAND_SWARM_SIZE, MIGRATION_INTERVAL, RING) {}
+
+/**
+ * Overloaded constructor that accepts values for parameters
+ * Each island uses the default NDPSO parameters, except for its inertial discount; tune them through getIsland()
+ *
+ * @param int numIslands
+ * @param int swarmSize: particles per island
+ * @param int migrationInterval: iterations between migrations
+ * @param Topology topology
+ **/
+IslandNDPSO::IslandNDPSO(int numIslands, int swarmSize, int migrationInterval, Topology topology) {
+    if (numIslands <= 0) throw "IslandNDPSO::IslandNDPSO(): need at least one island!";
+    this->swarmSize = swarmSize;
+    this->migrationInterval = migrationInterval;
+    this->numMigrants = MIGRANTS;
+    this->topology = topology;
+    this->maxIterations = MAX_ITERATIONS;
+    this->build(numIslands);
+}
+
+/**
+ * Destructor to clean out the islands
+ * Does NOT delete the Listener! That is the responsibility of the main program!
+ **/
+IslandNDPSO::~IslandNDPSO() {
+    this->clear();
+}
+
+/**
+ * Creates the islands and their mailboxes; island i discounts its inertia by INERTIAL_DISCOUNT^(i + 1)
+ *
+ * @param int numIslands
+ * @return void
+ **/
+void IslandNDPSO::build(int numIslands) {
+    this->clear();
+    for (int i = 0; i < numIslands; i++) {
+        float discount = pow(INERTIAL_DISCOUNT, i + 1);
+        this->islands.push_back(new NDPSO(SOCIAL, COGNITIVE, INERTIA, discount, this->swarmSize, this->maxIterations));
+        this->mailboxes.push_back(new Mailbox(numIslands));
+    }
+}
+
+void IslandNDPSO::clear() {
+    for (NDPSO* island : this->islands) {
+        delete island;
+    }
+    for (Mailbox* mailbox : this->mailboxes) {
+        delete mailbox;
+    }
+    this->islands.clear();
+    this->mailboxes.clear();
+}
+
+string IslandNDPSO::getJSONParameters() {
+    string json = "{";
+    json += "numIslands: "          + to_string(this->islands.size());
+    json += ", swarmSize: "         + to_string(this->swarmSize);
+    json += ", migrationInterval: " + to_string(this->migrationInterval);
+    json += ", numMigrants: "       + to_string(this->numMigrants);
+    json += ", topology: "          + string(this->topology == RING ? "\"ring\"" : "\"random\"");
+    json += ", maxIterations: "     + to_string(this->maxIterations);
+    json += ", ndpso: "             + this->islands[0]->getJSONParameters();
+    json += "}";
+    return json;
+}
+
+/**
+ * Seeds every island from this run's generator and builds their swarms in parallel
+ **/
+void IslandNDPSO::setup() {
+    for (NDPSO* island : this->islands) {
+        island->setSeed(this->rng.next());
+        island->setMaxIterations(this->maxIterations);
+    }
+    ThreadPool::getInstance().parallelFor(this->islands.size(), [this](int i) {
+        this->islands[i]->init(this->data);
+    });
+    this->convergence.assign(this->islands.size(), vector<int>());
+    this->recordConvergence();
+}
+
+/**
+ * Same as setup(), but every island's swarm starts around the given solution
+ *
+ * @param const vector<int>& facilities
+ **/
+void IslandNDPSO::setupFrom(const vector<int>& facilities) {
+    for (NDPSO* island : this->islands) {
+        island->setSeed(this->rng.next());
+        island->setMaxIterations(this->maxIterations);
+    }
+    ThreadPool::getInstance().parallelFor(this->islands.size(), [&](int i) {
+        this->islands[i]->warmStart(this->data, facilities);
+    });
+    this->convergence.assign(this->islands.size(), vector<int>());
+    this->recordConvergence();
+}
+
+/**
+ * One iteration of every island, side by side, then a migration if one is due
+ * step() doesn't go through here: it hands the islands whole chunks of iterations so the threads aren't synchronized every iteration
+ **/
+void IslandNDPSO::iterate() {
+    ThreadPool::getInstance().parallelFor(this->islands.size(), [&](int i) {
+        this->islands[i]->step(1);
+    });
+    if (this->migrationInterval > 0 && this->iteration % this->migrationInterval == 0 && !this->cancelled) {
+        this->migrate();
+    }
+}
+
+/**
+ * Runs the given number of iterations in every island, one island per thread
+ * Chunks stop at every migration (and at every checkpoint, if an interval is set), so all of the islands are at the same iteration;
+ * the listener gets the best island's best solution after every chunk (the islands themselves have no listener)
+ *
+ * @param int iterations
+ * @return int number of iterations actually run (by the longest-running island)
+ **/
+int IslandNDPSO::step(int iterations) {
+    auto begin = chrono::steady_clock::now();
+    int total = 0;
+    while (total < iterations && !this->isDone()) {
+        int chunk = min(iterations - total, this->maxIterations - this->iteration);
+        if (this->migrationInterval > 0) {
+            chunk = min(chunk, this->migrationInterval - this->iteration % this->migrationInterval);
+        }
+        if (this->checkpointInterval > 0) {
+            chunk = min(chunk, this->checkpointInterval - this->iteration % this->checkpointInterval);
+        }
+        vector<int> ran (this->islands.size(), 0);
+        ThreadPool::getInstance().parallelFor(this->islands.size(), [&](int i) {
+            ran[i] = this->islands[i]->step(chunk);
+        });
+        int most = *max_element(ran.begin(), ran.end());
+        if (most == 0) break;    // every island has been cancelled
+        this->iteration += most;
+        total += most;
+
+        if (this->migrationInterval > 0 && this->iteration % this->migrationInterval == 0 && !this->cancelled) {
+            this->migrate();
+        }
+        if (this->listener != nullptr) {
+            this->listener->handleResults(this->best());
+        }
+        if (this->isCheckpointDue()) {
+            auto now = chrono::steady_clock::now();
+            this->elapsed += chrono::duration<float>(now - begin).count();
+            begin = now;
+            this->saveCheckpoint();
+        }
+    }
+    this->elapsed += chrono::duration<float>(chrono::steady_clock::now() - begin).count();
+    return total;
+}
+
+/**
+ * Sends every island's best numMigrants personal bests to the next island of the topology, then lets every island take its mail
+ * The destinations are drawn up front from this run's generator, so a random topology is as reproducible as the ring
+ *
+ * @return void
+ **/
+void IslandNDPSO::migrate() {
+    int numIslands = this->islands.size();
+    if (numIslands > 1) {
+        vector<int> destinations (numIslands);
+        for (int i = 0; i < numIslands; i++) {
+            if (this->topology == RING) {
+                destinations[i] = (i + 1) % numIslands;
+            } else {
+                destinations[i] = (i + 1 + this->rng.nextInt(numIslands - 1)) % numIslands;  // anyone but itself
+            }
+        }
+
+        ThreadPool::getInstance().parallelFor(numIslands, [&](int i) {
+            static thread_local vector<int> positions, fitnesses;
+            this->islands[i]->getMigrants(this->numMigrants, positions, fitnesses);
+            this->mailboxes[destinations[i]]->post(i, positions, fitnesses);
+        });
+        ThreadPool::getInstance().parallelFor(numIslands, [&](int i) {
+            int p = this->data.numFacilities;
+            this->mailboxes[i]->drain([&](const vector<int>& positions, const vector<int>& fitnesses) {
+                for (int k = 0; k < (int) fitnesses.size(); k++) {
+                    this->islands[i]->addMigrant(positions.data() + k * p, fitnesses[k]);
+                }
+            });
+        });
+    }
+    this->recordConvergence();
+}
+
+void IslandNDPSO::recordConvergence() {
+    for (int i = 0; i < (int) this->islands.size(); i++) {
+        this->convergence[i].push_back(this->islands[i]->getBestFitness());
+    }
+}
+
+/**
+ * Returns every island's best objective at the start and after every migration so far
+ *
+ * @return [[island 0's objectives], [island 1's objectives], ...]
+ **/
+string IslandNDPSO::getJSONConvergence() {
+    string json = "[";
+    for (int i = 0; i < (int) this->convergence.size(); i++) {
+        json += (i > 0 ? ", [" : "[");
+        for (int k = 0; k < (int) this->convergence[i].size(); k++) {
+            json += (k > 0 ? ", " : "") + to_string(this->convergence[i][k]);
+        }
+        json += "]";
+    }
+    return json + "]";
+}
+
+/**
+ * Writes the migration parameters, every island's own checkpoint and the convergence history
+ * Mailboxes are always empty between chunks, so there's nothing to write for them
+ *
+ * @param SnapshotWriter& out
+ * @return void
+ **/
+void IslandNDPSO::saveState(SnapshotWriter& out) {
+    out.putInt(this->swarmSize);
+    out.putInt(this->migrationInterval);
+    out.putInt(this->numMigrants);
+    out.putInt(this->topology);
+    out.putInt(this->islands.size());
+    for (int i = 0; i < (int) this->islands.size(); i++) {
+        out.putString(this->islands[i]->checkpoint());
+        out.putVector(this->convergence[i]);
+    }
+}
+
+/**
+ * Resumes every island from its checkpoint, rebuilding the islands if the checkpoint has a different number of them
+ *
+ * @param SnapshotReader& in
+ * @return void
+ **/
+void IslandNDPSO::loadState(SnapshotReader& in) {
+    this->swarmSize         = in.getInt();
+    this->migrationInterval = in.getInt();
+    this->numMigrants       = in.getInt();
+    this->topology          = (Topology) in.getInt();
+    int numIslands = in.getInt();
+    if (numIslands <= 0) throw "IslandNDPSO::loadState(): corrupt checkpoint!";
+    if (numIslands != (int) this->islands.size()) {
+        this->build(numIslands);
+    }
+    this->convergence.assign(numIslands, vector<int>());
+    for (int i = 0; i < numIslands; i++) {
+        this->islands[i]->resume(this->data, in.getString());
+        this->convergence[i] = in.getVector();
+    }
+}
+
+void IslandNDPSO::cancel() {
+    Algorithm::cancel();
+    for (NDPSO* island : this->islands) {
+        island->cancel();
+    }
+}
+
+/**
+ * Adds up what bounded evaluations saved across every island
+ *
+ * @return BoundStats
+ **/
+BoundStats IslandNDPSO::getBoundStats() {
+    BoundStats stats;
+    for (NDPSO* island : this->islands) {
+        stats.add(island->getBoundStats());
+    }
+    return stats;
+}
+
+/**
+ * Returns the best solution found so far across every island
+ *
+ * @return ProblemResults
+ **/
+ProblemResults IslandNDPSO::best() {
+    int bestIsland = 0;
+    for (int i = 1; i < (int) this->islands.size(); i++) {
+        if (this->comparator(this->islands[i]->getBestFitness(), this->islands[bestIsland]->getBestFitness())) {
+            bestIsland = i;
+        }
+    }
+    ProblemResults best = this->islands[bestIsland]->best();
+    best.time = this->elapsed;
+    return best;
+}
@@ -0,0 +1,114 @@
+#ifndef ISLANDNDPSO_H
+#define ISLANDNDPSO_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include "NDPSO.h"
+#include "Algorithm.h"
+using namespace std;
+
+// default values for parameters
+const int ISLAND_COUNT       = 4;
+const int ISLAND_SWARM_SIZE  = 25;      // per island, so the default islands hold as many particles as one default swarm
+const int MIGRATION_INTERVAL = 25;      // iterations between migrations
+const int MIGRANTS           = 2;       // particles each island sends per migration
+
+// where each island's migrants go
+enum Topology {
+    RING,                   // island i always sends to island i + 1
+    RANDOM_DESTINATION      // every migration, each island sends to another island picked at random
+};
+
+/**
+ * One island's incoming migrants, with a slot per sending island
+ * Every slot has exactly one writer, so senders never contend and no lock is needed:
+ * a sender fills its slot and publishes it with a release store, the owner acquires it before reading
+ **/
+class Mailbox {
+public:
+    Mailbox(int numSenders) : letters(new Letter[numSenders]), numSenders(numSenders) {}
+
+    // called by the sending island
+    void post(int sender, const vector<int>& positions, const vector<int>& fitnesses) {
+        Letter& letter = this->letters[sender];
+        letter.positions = positions;
+        letter.fitnesses = fitnesses;
+        letter.full.store(true, memory_order_release);
+    }
+
+    // called by the owning island; visits every waiting letter in sender order and empties the box
+    template<typename Visit>
+    void drain(Visit visit) {
+        for (int sender = 0; sender < this->numSenders; sender++) {
+            Letter& letter = this->letters[sender];
+            if (!letter.full.load(memory_order_acquire)) continue;
+            visit(letter.positions, letter.fitnesses);
+            letter.full.store(false, memory_order_relaxed);
+        }
+    }
+
+private:
+    struct Letter {
+        vector<int> positions;      // the migrants' facilities, one after the other
+        vector<int> fitnesses;
+        atomic<bool> full { false };
+    };
+    unique_ptr<Letter[]> letters;
+    int numSenders;
+};
+
+/**
+ * Runs several NDPSO sub-swarms ("islands") side by side, one per thread from the ThreadPool when available,
+ * and every so many iterations migrates each island's best personal bests to another island (see Topology),
+ * where they replace that island's worst particles.
+ * The islands cool their inertia at different rates (island i discounts by INERTIAL_DISCOUNT^(i + 1)),
+ * so some keep exploring while others settle.
+ *
+ * Migration happens at the end of a chunk of iterations: every island posts its migrants, then every island takes its mail.
+ * Both halves run in parallel, but a barrier separates them, so runs are reproducible whatever the number of threads.
+ * The best objective of every island is recorded at each migration (getJSONConvergence()).
+ **/
+class IslandNDPSO : public Algorithm {
+public:
+    IslandNDPSO();
+    IslandNDPSO(int);                       // number of islands
+    IslandNDPSO(int, int, int, Topology);   // islands, swarm size per island, migration interval, topology
+    ~IslandNDPSO();
+    string getName() override { return "IslandNDPSO"; }
+    string getJSONParameters() override;
+    ProblemResults best() override;
+    int  step(int) override;
+    void cancel() override;
+    BoundStats getBoundStats() override;
+    string getJSONConvergence();
+    int  getNumIslands() { return this->islands.size(); }
+    NDPSO* getIsland(int i) { return this->islands[i]; }
+    void setMigrationInterval(int val) { this->migrationInterval = val; }
+    void setNumMigrants(int val) { this->numMigrants = val; }
+    void setTopology(Topology val) { this->topology = val; }
+protected:
+    void setup() override;
+    void setupFrom(const vector<int>&) override;
+    void iterate() override;
+    void saveState(SnapshotWriter&) override;
+    void loadState(SnapshotReader&) override;
+private:
+    /* members */
+    vector<NDPSO*> islands;
+    vector<Mailbox*> mailboxes;     // mailboxes[i] holds island i's incoming migrants
+    vector<vector<int>> convergence;    // convergence[i]: island i's best objective at the start and after every migration
+    int swarmSize;
+    int migrationInterval;
+    int numMigrants;
+    Topology topology;
+
+    /* functions */
+    void build(int);
+    void clear();
+    void migrate();
+    void recordConvergence();
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <climits>
+#include "VecOps.h"
+
+/**
+ * Evaluation kernels shared by every algorithm
+ * The int loops run VecOps::WIDTH lanes at a time with a scalar tail, so the same code serves the
+ * native SSE/AVX build and the WASM SIMD128 build (and the plain scalar builds)
+ **/
+namespace Kernels {
+
+    /**
+     * Folds one facility's cost row into the running nearest-facility arrays
+     * A customer moves to the new facility only if it is strictly cheaper, so ties keep the earlier facility
+     * Templated on the cost storage (int or int16_t), so a compact matrix streams half the bytes
+     *
+     * @param const Cost* row:  costs from the facility to every customer
+     * @param int* bestCosts:   cheapest cost seen so far per customer
+     * @param int* bestLabels:  label of the facility that cost belongs to, per customer
+     * @param int label:        what to write into bestLabels for this facility (its id or its slot)
+     * @param int n:            number of customers
+     **/
+    template<typename Cost>
+    inline void nearestUpdate(const Cost* row, int* bestCosts, int* bestLabels, int label, int n) {
+        int cust = 0;
+        VecOps::Int labels = VecOps::splat(label);
+        for (; cust + VecOps::WIDTH <= n; cust += VecOps::WIDTH) {
+            VecOps::Int costs = VecOps::load(row + cust);
+            VecOps::Int best  = VecOps::load(bestCosts + cust);
+            VecOps::Int mask  = VecOps::lessThan(costs, best);
+            VecOps::store(bestCosts + cust, VecOps::min(costs, best));
+            VecOps::store(bestLabels + cust, VecOps::select(mask, labels, VecOps::load(bestLabels + cust)));
+        }
+        for (; cust < n; cust++) {
+            if (row[cust] < bestCosts[cust]) {
+                bestCosts[cust]  = row[cust];
+                bestLabels[cust] = label;
+            }
+        }
+    }
+
+    // clamps a wide sum to what an objective can hold, so a sum too big for an int reads as the worst objective instead of wrapping
+    inline int saturate(long long value) {
+        return (int) (value > INT_MAX ? INT_MAX : (value < INT_MIN ? INT_MIN : value));
+    }
+
+    // the sums below can outgrow an int (demand * cost over thousands of customers), and a lane is only 32 bits wide,
+    // so they accumulate in long long as plain loops, which the compiler still vectorizes with widening multiplies
+    inline long long sum(const int* values, int n) {
+        long long total = 0;
+        for (int i = 0; i < n; i++) total += values[i];
+        return total;
+    }
+
+    // sum of values[i] * weights[i], e.g. demand-weighted costs
+    inline long long dot(const int* values, const int* weights, int n) {
+        long long total = 0;
+        for (int i = 0; i < n; i++) total += (long long) values[i] * weights[i];
+        return total;
+    }
+
+    // sum of min(row[i], bestCosts[i]) * weights[i]: the demand-weighted nearest costs if row's facility were opened too
+    template<typename Cost>
+    inline long long dotMin(const Cost* row, const int* bestCosts, const int* weights, int n) {
+        long long total = 0;
+        for (int i = 0; i < n; i++) total += (long long) (row[i] < bestCosts[i] ? (int) row[i] : bestCosts[i]) * weights[i];
+        return total;
+    }
+
+    inline int max(const int* values, int n) {
+        int i = 0;
+        VecOps::Int acc = VecOps::splat(INT_MIN);
+        for (; i + VecOps::WIDTH <= n; i += VecOps::WIDTH) {
+            acc = VecOps::max(acc, VecOps::load(values + i));
+        }
+        int lanes[VecOps::WIDTH];
+        VecOps::store(lanes, acc);
+        int best = INT_MIN;
+        for (int lane = 0; lane < VecOps::WIDTH; lane++) best = (lanes[lane] > best ? lanes[lane] : best);
+        for (; i < n; i++) best = (values[i] > best ? values[i] : best);
+        return best;
+    }
+
+    inline int min(const int* values, int n) {
+        int i = 0;
+        VecOps::Int acc = VecOps::splat(INT_MAX);
+        for (; i + VecOps::WIDTH <= n; i += VecOps::WIDTH) {
+            acc = VecOps::min(acc, VecOps::load(values + i));
+        }
+        int lanes[VecOps::WIDTH];
+        VecOps::store(lanes, acc);
+        int best = INT_MAX;
+        for (int lane = 0; lane < VecOps::WIDTH; lane++) best = (lanes[lane] < best ? lanes[lane] : best);
+        for (; i < n; i++) best = (values[i] < best ? values[i] : best);
+        return best;
+    }
+}
+
+#endif
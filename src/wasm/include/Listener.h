@@ -14,6 +14,7 @@ public:
     virtual void handleAlgorithm(Algorithm*, std::string, ProblemType) = 0;
     virtual void handleResults(ProblemResults) = 0;
     virtual void handleParticle(Particle*, int) = 0;
+    virtual void handleCheckpoint(const std::string&, int) {}     // only called when a checkpoint interval is set
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "MultiStartALNS.h"
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include "ALNS.h"
+#include "ThreadPool.h"
+using namespace std;
+
+/**
+ * Default constructor
+ * Uses MULTI_START_COUNT starts with the default ALNS parameters
+ **/
+MultiStartALNS::MultiStartALNS() : MultiStartALNS(MULTI_START_COUNT) {}
+
+/**
+ * Constructor for setting the number of independent starts
+ * Each start uses the default ALNS parameters; tune them through getStart()
+ *
+ * @param int numStarts
+ **/
+MultiStartALNS::MultiStartALNS(int numStarts) {
+    for (int i = 0; i < numStarts; i++) {
+        this->starts.push_back(new ALNS());
+    }
+    this->maxIterations = ALNS_MAX_ITERS;
+}
+
+/**
+ * Destructor to clean out the starts
+ * Does NOT delete the Listener! That is the responsibility of the main program!
+ **/
+MultiStartALNS::~MultiStartALNS() {
+    for (ALNS* start : this->starts) {
+        delete start;
+    }
+}
+
+string MultiStartALNS::getJSONParameters() {
+    string json = "{";
+    json += "numStarts: "       + to_string(this->starts.size());
+    json += ", maxIterations: " + to_string(this->maxIterations);
+    json += ", alns: "          + this->starts[0]->getJSONParameters();
+    json += "}";
+    return json;
+}
+
+/**
+ * Seeds every start from this run's generator and builds their initial solutions in parallel
+ **/
+void MultiStartALNS::setup() {
+    for (ALNS* start : this->starts) {
+        start->setSeed(this->rng.next());
+        start->setMaxIterations(this->maxIterations);
+    }
+    ThreadPool::getInstance().parallelFor(this->starts.size(), [this](int i) {
+        this->starts[i]->init(this->data);
+    });
+}
+
+/**
+ * Same as setup(), but every start begins from the given solution
+ *
+ * @param const vector<int>& facilities
+ **/
+void MultiStartALNS::setupFrom(const vector<int>& facilities) {
+    for (ALNS* start : this->starts) {
+        start->setSeed(this->rng.next());
+        start->setMaxIterations(this->maxIterations);
+    }
+    ThreadPool::getInstance().parallelFor(this->starts.size(), [&](int i) {
+        this->starts[i]->warmStart(this->data, facilities);
+    });
+}
+
+/**
+ * One iteration of every start, side by side
+ * step() doesn't go through here: it hands the starts whole chunks of iterations so the threads aren't synchronized every iteration
+ **/
+void MultiStartALNS::iterate() {
+    ThreadPool::getInstance().parallelFor(this->starts.size(), [&](int i) {
+        this->starts[i]->step(1);
+    });
+}
+
+/**
+ * Runs the given number of iterations in every start, one start per thread
+ * With a checkpoint interval set, the chunks stop at every interval so the checkpoint sees all of the starts at the same iteration
+ *
+ * @param int iterations
+ * @return int number of iterations actually run (by the longest-running start)
+ **/
+int MultiStartALNS::step(int iterations) {
+    auto begin = chrono::steady_clock::now();
+    int total = 0;
+    while (total < iterations && !this->isDone()) {
+        int chunk = min(iterations - total, this->maxIterations - this->iteration);
+        if (this->checkpointInterval > 0) {
+            chunk = min(chunk, this->checkpointInterval - this->iteration % this->checkpointInterval);
+        }
+        vector<int> ran (this->starts.size(), 0);
+        ThreadPool::getInstance().parallelFor(this->starts.size(), [&](int i) {
+            ran[i] = this->starts[i]->step(chunk);
+        });
+        int most = *max_element(ran.begin(), ran.end());
+        if (most == 0) break;    // every start has been cancelled
+        this->iteration += most;
+        total += most;
+
+        if (this->isCheckpointDue()) {
+            auto now = chrono::steady_clock::now();
+            this->elapsed += chrono::duration<float>(now - begin).count();
+            begin = now;
+            this->saveCheckpoint();
+        }
+    }
+    this->elapsed += chrono::duration<float>(chrono::steady_clock::now() - begin).count();
+    return total;
+}
+
+/**
+ * Writes every start's own checkpoint
+ *
+ * @param SnapshotWriter& out
+ * @return void
+ **/
+void MultiStartALNS::saveState(SnapshotWriter& out) {
+    out.putInt(this->starts.size());
+    for (ALNS* start : this->starts) {
+        out.putString(start->checkpoint());
+    }
+}
+
+/**
+ * Resumes every start from its checkpoint, rebuilding the starts if the checkpoint has a different number of them
+ *
+ * @param SnapshotReader& in
+ * @return void
+ **/
+void MultiStartALNS::loadState(SnapshotReader& in) {
+    int numStarts = in.getInt();
+    if (numStarts <= 0) throw "MultiStartALNS::loadState(): corrupt checkpoint!";
+    while ((int)this->starts.size() > numStarts) {
+        delete this->starts.back();
+        this->starts.pop_back();
+    }
+    while ((int)this->starts.size() < numStarts) {
+        this->starts.push_back(new ALNS());
+    }
+    for (ALNS* start : this->starts) {
+        start->resume(this->data, in.getString());
+    }
+}
+
+void MultiStartALNS::cancel() {
+    Algorithm::cancel();
+    for (ALNS* start : this->starts) {
+        start->cancel();
+    }
+}
+
+/**
+ * Adds up what bounded evaluations saved across every start
+ *
+ * @return BoundStats
+ **/
+BoundStats MultiStartALNS::getBoundStats() {
+    BoundStats stats;
+    for (ALNS* start : this->starts) {
+        stats.add(start->getBoundStats());
+    }
+    return stats;
+}
+
+/**
+ * Returns the best solution found so far across every start
+ *
+ * @return ProblemResults
+ **/
+ProblemResults MultiStartALNS::best() {
+    ProblemResults best = this->starts[0]->best();
+    for (int i = 1; i < (int) this->starts.size(); i++) {
+        ProblemResults results = this->starts[i]->best();
+        if (this->comparator(results.objective, best.objective)) {
+            best = results;
+        }
+    }
+    best.time = this->elapsed;
+    return best;
+}
@@ -0,0 +1,41 @@
+#ifndef MULTISTARTALNS_H
+#define MULTISTARTALNS_H
+
+#include <vector>
+#include "ALNS.h"
+#include "Algorithm.h"
+using namespace std;
+
+// default values for parameters
+const int MULTI_START_COUNT = 4;
+
+
+
+/**
+ * Runs several independently seeded ALNS searches side by side and reports the best of them
+ * Each start gets its own thread from the ThreadPool when one is available
+ **/
+class MultiStartALNS : public Algorithm {
+public:
+    MultiStartALNS();
+    MultiStartALNS(int);    // number of starts
+    ~MultiStartALNS();
+    string getName() override { return "MultiStartALNS"; }
+    string getJSONParameters() override;
+    ProblemResults best() override;
+    int  step(int) override;
+    void cancel() override;
+    BoundStats getBoundStats() override;
+    int  getNumStarts() { return this->starts.size(); }
+    ALNS* getStart(int i) { return this->starts[i]; }
+protected:
+    void setup() override;
+    void setupFrom(const vector<int>&) override;
+    void iterate() override;
+    void saveState(SnapshotWriter&) override;
+    void loadState(SnapshotReader&) override;
+private:
+    vector<ALNS*> starts;
+};
+
+#endif
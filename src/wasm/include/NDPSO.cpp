@@ -9,13 +9,10 @@
 #include <algorithm>
 #include "Utils.h"
 #include "Particle.h"
+#include "ThreadPool.h"
+#include "FacilitySet.h"
 using namespace std;
 
-/* functional object for getGlobalBest() && getGlobalWorst() */
-struct minFitness {
-    bool operator() (Particle left, Particle right) { return left.fitness < right.fitness; }
-};
-
 /**
  * Default constructor
  * Sets parameters to defaults found in NDPSO.h
@@ -85,42 +82,328 @@ string NDPSO::getJSONParameters() {
 }
 
 /**
- * Optimizes a given problem
+ * Sets up the search for this->data
  * initializes swarm
  *  todo: log intermediate steps to a logfile (database table?)
- * @param ProblemData problem
- * @return ProblemResults
  **/
-ProblemResults NDPSO::optimize(ProblemData data) {
-    // initial setup
-    this->data = data;
-    this->comparator.setType(data.type.objective);
+void NDPSO::setup() {
+    this->cache.clear();
     this->initSwarm();
-    Particle gBest = getGlobalBest();   // global best; across current iteration
-    Particle uBest = gBest;             // universal best; across all iterations
+    this->gBest = getGlobalBest();
+    this->setUniversalBest(this->gBest);
 
     // re-initialize our potentially already discounted inertia to its starting value
     this->inertia = this->initialInertia;
+}
+
+/**
+ * Sets up the search around a known solution (see initSwarmAround())
+ *
+ * @param const vector<int>& facilities
+ **/
+void NDPSO::setupFrom(const vector<int>& facilities) {
+    this->cache.clear();
+    this->initSwarmAround(facilities);
+    this->gBest = getGlobalBest();
+    this->setUniversalBest(this->gBest);
+    this->inertia = this->initialInertia;
+}
+
+/**
+ * Moves every particle once and updates the global/universal bests
+ * Every particle draws its exchanges first (the rng isn't shared across threads),
+ * then all of the exchanged candidates are evaluated together in one batch (see BatchEvaluator),
+ * then each particle keeps its best
+ * Everything lives in buffers sized by allocateSwarm(), so once they've warmed up an iteration doesn't allocate
+ **/
+void NDPSO::iterate() {
+    inertia *= inertialDiscount;
+    this->batch.clear();
+    for (int i = 0; i < this->swarmSize; i++) {
+        this->propose(i);
+        this->queue(i);
+    }
+    this->batch.evaluate(this->data);
+    ThreadPool::getInstance().parallelFor(this->swarmSize, [this](int i) {
+        this->collect(i);
+    });
+
+    // the global best's state is the source of the others' global best candidates, so it moves last
+    for (int i = 0; i < this->swarmSize; i++) {
+        if (i != this->gBest) this->commit(i);
+    }
+    this->commit(this->gBest);
+    for (BoundStats& stats : this->particleBoundStats) {
+        this->boundStats.add(stats);
+        stats = BoundStats();
+    }
+
+    this->gBest = getGlobalBest();
+    if (this->comparator(this->fitnesses[this->gBest], uBest.fitness)) {
+        this->setUniversalBest(this->gBest);
+    }
+
+    if (this->listener != nullptr) {
+        listener->handleParticle(&uBest, this->iteration);
+    }
+}
+
+/**
+ * Draws particle i's exchanges on its current position, personal best and the global best
+ * This algorithm uses a different PSO method: we perform random one-facility-exchanges on different facility vectors with the probability of different parameters
+ *     + current position is governed by inertia
+ *     + persaonl best is governed by the cognitive parameter
+ *     + global best is governed by the social parameter
+ * commit() later takes the best of the three.
+ *
+ * @param int i
+ * @return void
+ **/
+void NDPSO::propose(int i) {
+    this->proposeSinglePosition(i, 0, this->position(i), this->fitnesses[i], this->inertia);
+    this->proposeSinglePosition(i, 1, this->pBestPosition(i), this->pBestFitnesses[i], this->cognitive);
+    this->proposeSinglePosition(i, 2, this->position(this->gBest), this->fitnesses[this->gBest], this->social);
+}
+
+/**
+ * Copies a position into one of particle i's candidates and exchanges it with the given probability
+ *
+ * @param int i
+ * @param int which
+ * @param const int* position
+ * @param int fitness
+ * @param float probability
+ * @return void
+ **/
+void NDPSO::proposeSinglePosition(int i, int which, const int* position, int fitness, const float probability) {
+    int c = 3 * i + which;
+    if (this->rng.nextInt(100) / 100.0 <= probability) {
+        this->exchange(position, this->candidate(c), &this->exchanged[c]);
+        this->pending[c] = true;
+    } else {
+        copy(position, position + this->numDimensions, this->candidate(c));
+        this->candidateFitnesses[c] = fitness;
+        this->exchanged[c] = -1;
+        this->pending[c] = false;
+    }
+}
+
+/**
+ * Queues particle i's exchanged candidates that need a full evaluation (all of them, unless states are kept) into the batch
+ * A candidate whose facility set is already in the objective cache takes its objective from there instead.
+ * Only a candidate that can match or beat the best of the unexchanged ones needs its exact objective,
+ * so on a problem that isBoundable() that best is its cutoff (see BatchEvaluator)
+ *
+ * @param int i
+ * @return void
+ **/
+void NDPSO::queue(int i) {
+    for (int c = 3 * i; c < 3 * i + 3; c++) {
+        if (!this->pending[c]) continue;
+        this->keys[c] = ObjectiveCache::key(this->candidate(c), this->numDimensions);
+        if (this->cache.lookup(this->keys[c], this->candidateFitnesses[c])) {
+            this->pending[c] = false;
+        }
+    }
+
+    bool known = false;
+    int  cutoff = INT_MAX;
+    for (int c = 3 * i; c < 3 * i + 3; c++) {
+        if (!this->pending[c]) {
+            cutoff = (known ? this->comparator.getBetter(cutoff, this->candidateFitnesses[c]) : this->candidateFitnesses[c]);
+            known = true;
+        }
+    }
+    if (!this->data.isBoundable()) {
+        cutoff = INT_MAX;
+    }
+
+    for (int c = 3 * i; c < 3 * i + 3; c++) {
+        this->batchIndex[c] = -1;
+        if (this->pending[c] && !(this->isIncremental() && this->exchanged[c] >= 0)) {
+            this->batchIndex[c] = this->batch.add(this->candidate(c), this->numDimensions, cutoff);
+        }
+    }
+}
+
+/**
+ * Fills in the objectives of particle i's exchanged candidates: from the evaluated batch, or by replaying the exchange on a kept state
+ * The exact ones go into the objective cache. Safe to call concurrently for different particles
+ *
+ * @param int i
+ * @return void
+ **/
+void NDPSO::collect(int i) {
+    for (int which = 0; which < 3; which++) {
+        int c = 3 * i + which;
+        if (!this->pending[c]) continue;
+        int index = this->batchIndex[c];
+        if (index >= 0) {
+            this->candidateFitnesses[c] = this->batch.getObjective(index);
+            if (this->batch.getCutoff(index) < INT_MAX) {
+                this->particleBoundStats[i].add(this->batch.getScanned(index), this->data.numCustomers);
+            }
+            if (this->batch.getScanned(index) == this->data.numCustomers) {
+                this->cache.store(this->keys[c], this->candidateFitnesses[c]);
+            }
+        } else {
+            static thread_local IncrementalObjective scratch;
+            int slot = this->exchanged[c];
+            scratch = this->source(i, which);
+            scratch.replace(this->data, slot, this->candidate(c)[slot]);
+            this->candidateFitnesses[c] = scratch.getObjective();
+            this->cache.store(this->keys[c], this->candidateFitnesses[c]);
+        }
+        this->pending[c] = false;
+    }
+}
+
+/**
+ * The kept state of the position one of particle i's candidates was copied from
+ *
+ * @param int i
+ * @param int which (0 = position, 1 = personal best, 2 = global best)
+ * @return const IncrementalObjective&
+ **/
+const IncrementalObjective& NDPSO::source(int i, int which) const {
+    switch (which) {
+        case 0:  return this->states[i];
+        case 1:  return this->pBestStates[i];
+        default: return this->states[this->gBest];
+    }
+}
+
+/**
+ * Takes the best of particle i's three candidates as its new position and updates its personal best
+ *
+ * @preconditions: assumes collect() has run, and that the global best particle hasn't moved yet (unless it's i)
+ * A candidate that lost a bounded evaluation has a fitness worse than some other candidate's, so it can't be picked
+ *
+ * @param int i
+ * @return void
+ **/
+void NDPSO::commit(int i) {
+    // get best of the new exchanges
+    const int* fitness = this->candidateFitnesses.data() + 3 * i;
+    int best, which;
+    best = this->comparator.getBetter(fitness[0], fitness[1]);
+    best = this->comparator.getBetter(fitness[2], best);
+    if (best == fitness[0]) {
+        which = 0;
+    } else if (best == fitness[1]) {
+        which = 1;
+    } else {
+        which = 2;
+    }
+    int c = 3 * i + which;
+    copy(this->candidate(c), this->candidate(c) + this->numDimensions, this->position(i));
+    this->fitnesses[i] = best;
 
-    // ladies and gentlemen, start your engines!
-    clock_t begin = clock();
-    for (int count = 1; count <= this->maxIterations; count++) {
-        inertia *= inertialDiscount;
-        for (Particle &particle : this->swarm) {
-            particle.update(gBest);
+    // replay the winning exchange on its source's state (collect() only kept the objective)
+    if (this->isIncremental()) {
+        if (which != 0) {
+            this->states[i] = this->source(i, which);
         }
-        gBest = getGlobalBest();
-        if (this->comparator(gBest.fitness, uBest.fitness)) {
-            uBest = gBest;
+        if (this->exchanged[c] >= 0) {
+            this->states[i].replace(this->data, this->exchanged[c], this->position(i)[this->exchanged[c]]);
         }
+    }
 
-        if (this->listener != nullptr) {
-            listener->handleParticle(&uBest, count);
+    // update personal best, if needed
+    if (this->comparator(this->fitnesses[i], this->pBestFitnesses[i])) {
+        copy(this->position(i), this->position(i) + this->numDimensions, this->pBestPosition(i));
+        this->pBestFitnesses[i] = this->fitnesses[i];
+        if (this->isIncremental()) {
+            this->pBestStates[i] = this->states[i];
         }
     }
+}
 
+/**
+ * Writes a position with one facility exchanged for one that isn't in it into out
+ * The draw itself is O(1), but the scratch set is assign()ed from the position every call, which is O(p) like the copy into out.
+ * Persistent per-position sets updated by swaps would not save that copy, would cost 2 * swarmSize sets of numCandidates entries,
+ * and would make the draws depend on each set's swap history, which checkpoints don't keep (see FacilitySet::clear())
+ *
+ * @param const int* position
+ * @param int* out: numDimensions entries, may not overlap position
+ * @param int* slot: if given, set to the slot that was exchanged (or -1 if none was, because every candidate is open)
+ * @return void
+ **/
+void NDPSO::exchange(const int* position, int* out, int* slot) {
+    FacilitySet& open = FacilitySet::forThread(this->data.numCandidates);
+    copy(position, position + this->numDimensions, out);
+
+    int toUnassign = this->rng.nextInt(this->numDimensions);
+    open.assign(position, this->numDimensions);
+    if (slot != nullptr) *slot = -1;
+    if (open.numClosed() > 0) {
+        out[toUnassign] = open.randomClosed(this->rng);
+        if (slot != nullptr) *slot = toUnassign;
+    }
+}
+
+/**
+ * Writes the parameters, the discounted inertia, the swarm and both bests
+ * Each particle is written as a Particle would save() itself, so older checkpoints still load
+ *
+ * @param SnapshotWriter& out
+ * @return void
+ **/
+void NDPSO::saveState(SnapshotWriter& out) {
+    out.putFloat(this->social);
+    out.putFloat(this->cognitive);
+    out.putFloat(this->inertia);
+    out.putFloat(this->initialInertia);
+    out.putFloat(this->inertialDiscount);
+    out.putInt(this->swarmSize);
+    Particle particle;
+    for (int i = 0; i <= this->swarmSize; i++) {
+        int from = (i < this->swarmSize ? i : this->gBest);     // then the global best
+        particle.assign(this->position(from), this->fitnesses[from], this->pBestPosition(from), this->pBestFitnesses[from], this->numDimensions);
+        particle.save(out);
+    }
+    this->uBest.save(out);
+}
+
+/**
+ * Reads back what saveState() wrote
+ * The global best is always the best particle of the swarm, so it's found again rather than read
+ *
+ * @param SnapshotReader& in
+ * @return void
+ **/
+void NDPSO::loadState(SnapshotReader& in) {
+    this->social           = in.getFloat();
+    this->cognitive        = in.getFloat();
+    this->inertia          = in.getFloat();
+    this->initialInertia   = in.getFloat();
+    this->inertialDiscount = in.getFloat();
+    this->cache.clear();
+    this->swarmSize = in.getInt();
+    this->allocateSwarm();
+    Particle particle;
+    for (int i = 0; i <= this->swarmSize; i++) {
+        particle.load(in, this);
+        if (i == this->swarmSize) break;   // the global best
+        copy(particle.position.begin(), particle.position.end(), this->position(i));
+        copy(particle.pBestPosition.begin(), particle.pBestPosition.end(), this->pBestPosition(i));
+        this->fitnesses[i]      = particle.fitness;
+        this->pBestFitnesses[i] = particle.pBestFitness;
+        this->resetStates(i);
+    }
+    this->gBest = getGlobalBest();
+    this->uBest.load(in, this);
+}
+
+/**
+ * Returns the best solution found so far
+ *
+ * @return ProblemResults
+ **/
+ProblemResults NDPSO::best() {
     ProblemResults results {
-                               float(clock() - begin) / CLOCKS_PER_SEC,
+                               this->elapsed,
                                uBest.fitness,
                                uBest.position,
                                uBest.getCustomerAssignments(),  // customer assignments are calculated deterministically
@@ -130,30 +413,179 @@ ProblemResults NDPSO::optimize(ProblemData data) {
 }
 
 /**
- * Returns the current global best in the swarm
- * @return Particle globalBest
+ * Returns the index of the current global best in the swarm (the first one, on ties)
+ * @return int globalBest
+ **/
+int NDPSO::getGlobalBest() {
+    int best = 0;
+    for (int i = 1; i < this->swarmSize; i++) {
+        if (this->comparator(this->fitnesses[i], this->fitnesses[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * Copies particle i into the universal best
+ *
+ * @param int i
+ * @return void
+ **/
+void NDPSO::setUniversalBest(int i) {
+    this->uBest.assign(this->position(i), this->fitnesses[i], this->pBestPosition(i), this->pBestFitnesses[i], this->numDimensions);
+}
+
+/**
+ * Copies out the best personal bests in the swarm, to migrate to another swarm
+ *
+ * @param int count: at most this many (fewer if the swarm is smaller)
+ * @param vector<int>& positions: set to their positions, one after the other
+ * @param vector<int>& fitnesses: set to their fitnesses
+ * @return void
  **/
-Particle NDPSO::getGlobalBest() {
-    minFitness func;
-    switch (this->data.type.objective) {
-        case MINIMIZE:
-            return *min_element(this->swarm.begin(), this->swarm.end(), func);
-        case MAXIMIZE:
-            return *max_element(this->swarm.begin(), this->swarm.end(), func);
-        default:
-            throw "NDPSO::getGlobalBest(): unrecognized this->data.objType!";
+void NDPSO::getMigrants(int count, vector<int>& positions, vector<int>& fitnesses) {
+    vector<int> order (this->swarmSize);
+    for (int i = 0; i < this->swarmSize; i++) order[i] = i;
+    count = min(count, this->swarmSize);
+    partial_sort(order.begin(), order.begin() + count, order.end(), [this](int left, int right) {
+        if (this->pBestFitnesses[left] != this->pBestFitnesses[right]) {
+            return this->comparator(this->pBestFitnesses[left], this->pBestFitnesses[right]);
+        }
+        return left < right;
+    });
+
+    positions.clear();
+    fitnesses.clear();
+    for (int k = 0; k < count; k++) {
+        positions.insert(positions.end(), this->pBestPosition(order[k]), this->pBestPosition(order[k]) + this->numDimensions);
+        fitnesses.push_back(this->pBestFitnesses[order[k]]);
+    }
+}
+
+/**
+ * Lets a migrant from another swarm replace the particle that's currently worst, if the migrant is better
+ * The migrant becomes both the position and the personal best of that particle
+ *
+ * @param const int* position: numFacilities facilities
+ * @param int fitness
+ * @return void
+ **/
+void NDPSO::addMigrant(const int* position, int fitness) {
+    int worst = 0;
+    for (int i = 1; i < this->swarmSize; i++) {
+        if (this->comparator(this->fitnesses[worst], this->fitnesses[i])) {
+            worst = i;
+        }
+    }
+    if (!this->comparator(fitness, this->fitnesses[worst])) return;
+
+    copy(position, position + this->numDimensions, this->position(worst));
+    copy(position, position + this->numDimensions, this->pBestPosition(worst));
+    this->fitnesses[worst]      = fitness;
+    this->pBestFitnesses[worst] = fitness;
+    this->resetStates(worst);
+    if (this->comparator(fitness, this->fitnesses[this->gBest])) {
+        this->gBest = worst;
+    }
+    if (this->comparator(fitness, this->uBest.fitness)) {
+        this->setUniversalBest(worst);
     }
 }
 
 /**
  * Overload of Algorithm::calcObjective to accept only a facilities vector because Particles aren't tracking customer assignments
+ * Goes through the objective cache, like the swarm's candidates
  *
  * @param vector<int>& facilities
  * @return int objective value for the problem type
  **/
 int NDPSO::calcObjective(const vector<int>& facilities) {
-    vector<int> customerAssignments = this->data.assignCustomers(facilities);
-    return this->data.calcObjective(customerAssignments);
+    uint64_t key = ObjectiveCache::key(facilities);
+    int objective;
+    if (!this->cache.lookup(key, objective)) {
+        objective = this->data.evaluate(facilities);
+        this->cache.store(key, objective);
+    }
+    return objective;
+}
+
+/**
+ * Sizes the swarm buffers for swarmSize particles of data.numFacilities facilities
+ *
+ * @return void
+ **/
+void NDPSO::allocateSwarm() {
+    int n = this->swarmSize;
+    this->numDimensions = this->data.numFacilities;
+    this->positions.assign(n * this->numDimensions, 0);
+    this->fitnesses.assign(n, 0);
+    this->pBestPositions.assign(n * this->numDimensions, 0);
+    this->pBestFitnesses.assign(n, 0);
+    this->candidates.assign(3 * n * this->numDimensions, 0);
+    this->candidateFitnesses.assign(3 * n, 0);
+    this->pending.assign(3 * n, false);
+    this->exchanged.assign(3 * n, -1);
+    this->batchIndex.assign(3 * n, -1);
+    this->keys.assign(3 * n, 0);
+    this->particleBoundStats.assign(n, BoundStats());
+    this->states.resize(this->isIncremental() ? n : 0);
+    this->pBestStates.resize(this->isIncremental() ? n : 0);
+    this->gBest = 0;
+    this->uBest = Particle(this);
+}
+
+/**
+ * Starts particle i on the given position, which is also its personal best
+ *
+ * @param int i
+ * @param const vector<int>& position
+ * @return void
+ **/
+void NDPSO::initParticle(int i, const vector<int>& position) {
+    copy(position.begin(), position.end(), this->position(i));
+    copy(position.begin(), position.end(), this->pBestPosition(i));
+    this->fitnesses[i]      = this->calcObjective(position);
+    this->pBestFitnesses[i] = this->fitnesses[i];
+    this->resetStates(i);
+}
+
+/**
+ * Recalculates particle i's kept states from its position and personal best, if they're kept
+ *
+ * @param int i
+ * @return void
+ **/
+void NDPSO::resetStates(int i) {
+    if (!this->isIncremental()) return;
+    vector<int> position (this->position(i), this->position(i) + this->numDimensions);
+    vector<int> pBestPosition (this->pBestPosition(i), this->pBestPosition(i) + this->numDimensions);
+    this->states[i].reset(this->data, position);
+    this->pBestStates[i] = this->states[i];
+    if (pBestPosition != position) {
+        this->pBestStates[i].reset(this->data, pBestPosition);
+    }
+}
+
+/**
+ * Initializes a swarm near the given position
+ * The first particle starts on it; the rest start one to three random exchanges away from it
+ *
+ * @param const vector<int>& position
+ **/
+void NDPSO::initSwarmAround(const vector<int>& position) {
+    this->allocateSwarm();
+    vector<int> start (position.size());
+    for (int i = 0; i < this->swarmSize; i++) {
+        start = position;
+        int numExchanges = (i == 0 ? 0 : 1 + this->rng.nextInt(3));
+        for (int j = 0; j < numExchanges; j++) {
+            vector<int> exchanged (start.size());
+            this->exchange(start.data(), exchanged.data());
+            start = exchanged;
+        }
+        this->initParticle(i, start);
+    }
 }
 
 /**
@@ -161,14 +593,17 @@ int NDPSO::calcObjective(const vector<int>& facilities) {
  *      --> this variation doesn't have velocities
  **/
 void NDPSO::initSwarm() {
-    if (this->swarm.size() > 0) { // clear old swarms from previous problems
-        this->swarm.clear();
-    }
+    this->allocateSwarm();
 
-    int numDimensions = this->data.numFacilities;
-    int possibleFacs  = this->data.numCustomers;
+    // randomly assign distinct facilities to every position
+    FacilitySet& open = FacilitySet::forThread(this->data.numCandidates);
+    vector<int> position (this->numDimensions);
     for (int i = 0; i < this->swarmSize; i++) {
-        Particle particle (numDimensions, possibleFacs, this);
-        this->swarm.push_back(particle);
+        open.clear();
+        for (int j = 0; j < this->numDimensions; j++) {
+            position[j] = open.randomClosed(this->rng);
+            open.open(position[j]);
+        }
+        this->initParticle(i, position);
     }
 }
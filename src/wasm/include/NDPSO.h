@@ -3,6 +3,9 @@
 
 #include "Algorithm.h"
 #include "Particle.h"
+#include "BatchEvaluator.h"
+#include "ObjectiveCache.h"
+#include "IncrementalObjective.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -26,33 +29,89 @@ public:
     NDPSO(int);                                   // just for setting maxIterations
     NDPSO(float, float, float, float, int, int);  // set all parameters
     ~NDPSO() {};
-    ProblemResults optimize(ProblemData) override;
     string getName() override { return "NDPSO"; };
     string getJSONParameters() override;
+    ProblemResults best() override;
     void setInertia(float c1) { this->inertia = c1; this->initialInertia = c1; }
     void setSocial(float c2) { this->social = c2; }
     void setCognitive(float c3) { this->cognitive = c3; }
+    CacheStats getCacheStats() { return this->cache.getStats(); }
+    string getJSONCacheStats() { return this->cache.getStats().getJSON(); }
+    int  getBestFitness() { return this->uBest.fitness; }
+
+    // migration between swarms (see IslandNDPSO)
+    void getMigrants(int, vector<int>&, vector<int>&);
+    void addMigrant(const int*, int);
 
     /* overridden functions */
         // Algorithm::calcObjective() && friends expects a vector of CUSTOMER ASSIGNMENTS
         // however, this metaheuristic works by manipulating a vector of FACILITY ASSIGNMENTS
         // we don't track or calculate customer assignments, so we need our own objective functions
     int calcObjective(const vector<int>&) override;
+protected:
+    void setup() override;
+    void setupFrom(const vector<int>&) override;
+    void iterate() override;
+    void saveState(SnapshotWriter&) override;
+    void loadState(SnapshotReader&) override;
 private:
     /* members */
-    vector<Particle> swarm;
+    // the swarm is kept as structure-of-arrays: particle i's position is positions[i * numDimensions ..] (see position()),
+    // and likewise for its personal best and its three candidates, so an iteration only ever writes into these buffers
+    int numDimensions = 0;          // facilities per position (data.numFacilities)
+    vector<int> positions;
+    vector<int> fitnesses;
+    vector<int> pBestPositions;
+    vector<int> pBestFitnesses;
+    int gBest = 0;                  // index of the global best particle; across current iteration
+    Particle uBest;                 // universal best; across all iterations
+
+    // this iteration's candidates: exchanged copies of each particle's position, personal best and the global best
+    // candidate c = 3 * i + which (0 = position, 1 = personal best, 2 = global best) of particle i
+    vector<int> candidates;
+    vector<int> candidateFitnesses;
+    vector<char> pending;           // whether a candidate was exchanged and still needs evaluating
+    vector<int> exchanged;          // which slot each candidate's exchange changed, or -1
+    vector<int> batchIndex;         // where queue() put each candidate in the batch, or -1
+    vector<uint64_t> keys;          // each candidate's ObjectiveCache key
+    vector<BoundStats> particleBoundStats;  // what each particle's bounded evaluations saved this iteration
+
+    // with enough facilities (isIncremental()) the assignments behind each position and personal best are kept,
+    // so a candidate one exchange away from them is evaluated with IncrementalObjective::replace()
+    vector<IncrementalObjective> states;
+    vector<IncrementalObjective> pBestStates;
+
     int   swarmSize;
-    int   maxIterations;
     float cognitive;
     float social;
     float inertia;          // since inertia is discounted, but we don't want the user to have to worry about it,
-    float initialInertia;   // we'll save the given inertia into initialInertia and reset inertia to initialInertia in optimize()
+    float initialInertia;   // we'll save the given inertia into initialInertia and reset inertia to initialInertia in setup()
     float inertialDiscount;
+    BatchEvaluator batch;   // this iteration's candidates, kept to reuse its buffers
+    ObjectiveCache cache;   // objectives of facility sets the swarm has already evaluated; cleared whenever this->data is set
 
     /* functions */
     void initSwarm();
-    Particle getGlobalBest();
-    Particle getGlobalWorst(); 
+    void initSwarmAround(const vector<int>&);
+    void allocateSwarm();
+    void initParticle(int, const vector<int>&);
+    void resetStates(int);
+    int  getGlobalBest();
+    void setUniversalBest(int);
+    bool isIncremental() const { return this->data.numFacilities >= INCREMENTAL_MIN_FACILITIES; }
+
+    // moving particle i: propose() draws its exchanges, queue() and collect() evaluate them (in the batch), commit() keeps the best
+    void propose(int);
+    void proposeSinglePosition(int, int, const int*, int, const float);
+    void queue(int);
+    void collect(int);
+    void commit(int);
+    void exchange(const int*, int*, int* = nullptr);
+    const IncrementalObjective& source(int, int) const;
+
+    int* position(int i) { return this->positions.data() + i * this->numDimensions; }
+    int* pBestPosition(int i) { return this->pBestPositions.data() + i * this->numDimensions; }
+    int* candidate(int c) { return this->candidates.data() + c * this->numDimensions; }
 };
 
 #endif
\ No newline at end of file
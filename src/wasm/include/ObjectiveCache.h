@@ -0,0 +1,112 @@
+#ifndef OBJECTIVECACHE_H
+#define OBJECTIVECACHE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// log2 of the number of entries in an ObjectiveCache (16 bytes each, so 1 MB)
+const int OBJECTIVE_CACHE_BITS = 16;
+
+struct CacheStats {
+    long long hits = 0;
+    long long misses = 0;
+
+    string getJSON() const {
+        return "{hits: " + to_string(this->hits) + ", misses: " + to_string(this->misses) + "}";
+    }
+};
+
+/**
+ * Fixed-size table of exact objectives, keyed by the set of open facilities
+ *     + the key is the XOR of a 64-bit hash of every facility (Zobrist hashing), so it doesn't depend on the order
+ *       of the facilities and a one-facility exchange changes it by key ^ hash(old) ^ hash(new)
+ *     + it's direct-mapped: a store simply overwrites whatever shared its index
+ *     + every entry is two words, the value and key ^ value; a reader only trusts an entry whose words XOR back to its key,
+ *       so concurrent lookup()s and store()s need no locks: a torn entry just reads as a miss
+ * Only exact objectives may be stored (not the lower bounds evaluateBounded() gives up with).
+ * The table is only valid for one problem, so the owner clear()s it whenever its data changes.
+ **/
+class ObjectiveCache {
+public:
+    ObjectiveCache(int bits = OBJECTIVE_CACHE_BITS) : mask((1ULL << bits) - 1), entries(new atomic<uint64_t>[2ULL << bits]) {
+        this->clear();
+    }
+
+    // splitmix64's finalizer: every bit of the facility index moves about half of the output bits
+    static uint64_t hash(int fac) {
+        uint64_t z = (uint64_t) fac + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t key(const vector<int>& facilities) { return key(facilities.data(), facilities.size()); }
+    static uint64_t key(const int* facilities, int count) {
+        uint64_t key = 0;
+        for (int i = 0; i < count; i++) { key ^= hash(facilities[i]); }
+        return key;
+    }
+
+    /**
+     * Looks up the objective of the facility set with the given key
+     *
+     * @param uint64_t key (see key())
+     * @param int& objective: set on a hit
+     * @return bool whether it was found
+     **/
+    bool lookup(uint64_t key, int& objective) {
+        uint64_t index = (key & this->mask) * 2;
+        uint64_t value = this->entries[index].load(memory_order_relaxed);
+        uint64_t check = this->entries[index + 1].load(memory_order_relaxed);
+        if ((value & FILLED) && (check ^ value) == key) {
+            objective = (int) (uint32_t) value;
+            this->hits.fetch_add(1, memory_order_relaxed);
+            return true;
+        }
+        this->misses.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Stores the exact objective of the facility set with the given key
+     *
+     * @param uint64_t key
+     * @param int objective
+     * @return void
+     **/
+    void store(uint64_t key, int objective) {
+        uint64_t index = (key & this->mask) * 2;
+        uint64_t value = FILLED | (uint32_t) objective;
+        this->entries[index].store(value, memory_order_relaxed);
+        this->entries[index + 1].store(key ^ value, memory_order_relaxed);
+    }
+
+    void clear() {
+        for (uint64_t i = 0; i < 2 * (this->mask + 1); i++) {
+            this->entries[i].store(0, memory_order_relaxed);
+        }
+        this->hits = 0;
+        this->misses = 0;
+    }
+
+    CacheStats getStats() const {
+        CacheStats stats;
+        stats.hits   = this->hits.load(memory_order_relaxed);
+        stats.misses = this->misses.load(memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    static const uint64_t FILLED = 1ULL << 32;  // marks a stored value, so an empty entry never matches a key of 0
+
+    uint64_t mask;
+    unique_ptr<atomic<uint64_t>[]> entries;     // entry i is [2i] = value, [2i + 1] = key ^ value
+    atomic<long long> hits { 0 };
+    atomic<long long> misses { 0 };
+};
+
+#endif
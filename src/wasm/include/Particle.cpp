@@ -24,86 +24,21 @@ string Particle::getJSONCustomers() {
 }
 
 /**
- * Updates the position of a particle
- * This algorithm uses a different PSO method: we perform random one-facility-exchanges on different facility vectors with the probability of different parameters
- *     + current position is governed by inertia
- *     + persaonl best is governed by the cognitive parameter
- *     + global best is governed by the social parameter
- * After all exchanges have (potentially) been performed, we take the best of the three.
- * Note that this new position vector's objective value does NOT have to be better than the Particle's current position vector's value!
+ * Copies a particle out of the swarm buffers
+ * Reuses the vectors' storage, so it doesn't allocate once they've reached the size
  *
- * @preconditions: assumes the particle has been initialized (pBestPosition && pBestFitness have been set)
- * @postconditions: promises to update this particle's current position and fitness, as well as its personal best position/fitness
- * @param const Particle& gBest (global best Particle)
- **/
-void Particle::update(const Particle& gBest) {
-    vector<int> s1 = position,
-                s2 = pBestPosition,
-                s3 = gBest.position;
-    int s1Fitness = fitness,
-        s2Fitness = pBestFitness,
-        s3Fitness = gBest.fitness;
-
-    this->updateSinglePosition(s1, s1Fitness, ndpso->inertia);
-    this->updateSinglePosition(s2, s2Fitness, ndpso->cognitive);
-    this->updateSinglePosition(s3, s3Fitness, ndpso->social);
-
-    // get best of the new exchanges
-    int best;
-    best = ndpso->comparator.getBetter(s1Fitness, s2Fitness);
-    best = ndpso->comparator.getBetter(s3Fitness, best);
-    if (best == s1Fitness) {
-        this->position = s1;
-    } else if (best == s2Fitness) {
-        this->position = s2;
-    } else {
-        this->position = s3;
-    }
-    this->fitness = best;
-
-    // update personal best, if needed
-    if (ndpso->comparator(this->fitness, this->pBestFitness)) {
-        this->pBestPosition = this->position;
-        this->pBestFitness  = this->fitness;
-    }
-}
-
-/**
- * Updates a single position. Modifies the first two parameters in place.
- *
- * @param vector<int>& position
- * @param int& fitness
- * @param float probability
- * @param bool shouldExclude=false
+ * @param const int* position
+ * @param int fitness
+ * @param const int* pBestPosition
+ * @param int pBestFitness
+ * @param int numDimensions: the length of both positions
  * @return void
  **/
-void Particle::updateSinglePosition(vector<int>& position, int& fitness, const float probability) {
-    if (rand() % 100 / 100.0 <= probability) {
-        position = exchange(position);
-        fitness  = ndpso->calcObjective(position);
-    }
-}
-
-/**
- * Exchanges one facility in a Particle's position vector
- * Returns a NEW vector--does NOT change the input parameter!
- *
- * @param const vector<int>& position
- * @return vector<int> new position vector with ONE facility exchanged
- **/
-vector<int> Particle::exchange(const vector<int>& pos) {
-    int possibleFacs = ndpso->data.numCustomers;
-    int toUnassign;
-    int newFacility;
-    vector<int> toReturn (pos);
-
-    toUnassign = rand() % pos.size();
-    do {
-        newFacility = rand() % possibleFacs;
-    } while (find(pos.begin(), pos.end(), newFacility) != pos.end());
-
-    toReturn[toUnassign] = newFacility;
-    return toReturn;
+void Particle::assign(const int* position, int fitness, const int* pBestPosition, int pBestFitness, int numDimensions) {
+    this->position.assign(position, position + numDimensions);
+    this->fitness = fitness;
+    this->pBestPosition.assign(pBestPosition, pBestPosition + numDimensions);
+    this->pBestFitness = pBestFitness;
 }
 
 /**
@@ -118,34 +53,29 @@ vector<int> Particle::getCustomerAssignments() {
 }
 
 /**
- * Constructor for the Particle structure
- * Initializes random facility assignments
+ * Writes the particle's position and personal best for NDPSO::saveState()
  *
- * @preconditions: assumes the problem has been initialized, and that srand() has been seeded
- * @postconditions: promises to be a fully-functional, ready-to-rock Particle when done
- * @param int numDimensions: in this case, the number of facilities to open
- * @param int possibleFacs: the exclusive upper bound of the numbers denoting which facilities can be opened
- *     --e.g., if we can open facilities in nodes [0, 99], then possibleFacs = 100
- * @param NDPSO* ndpso: a reference to the enclosing NDPSO instance (so we can access the data and parameters later)
+ * @param SnapshotWriter& out
+ * @return void
  **/
-Particle::Particle(int numDimensions, int possibleFacs, NDPSO* ndpso) {
-    this->ndpso = ndpso;
-
-    int fac;
-    vector<int>::iterator it;
-
-    // randomly assign facilities in the position vector
-    for (int i = 0; i < numDimensions; i++) {
-        // assign a facility that hasn't yet been assigned
-        do {
-            fac = rand() % possibleFacs;
-            it = find(position.begin(), position.end(), fac);
-        } while (it != position.end());
-        position.push_back(fac);
-    }
+void Particle::save(SnapshotWriter& out) const {
+    out.putVector(this->position);
+    out.putInt(this->fitness);
+    out.putVector(this->pBestPosition);
+    out.putInt(this->pBestFitness);
+}
 
-    // calculate fitness and assign personal bests
-    fitness = ndpso->calcObjective(position);
-    pBestPosition = position;
-    pBestFitness  = fitness;
+/**
+ * Reads back what save() wrote
+ *
+ * @param SnapshotReader& in
+ * @param NDPSO* ndpso: the NDPSO instance the particle now belongs to
+ * @return void
+ **/
+void Particle::load(SnapshotReader& in, NDPSO* ndpso) {
+    this->ndpso = ndpso;
+    this->position      = in.getVector();
+    this->fitness       = in.getInt();
+    this->pBestPosition = in.getVector();
+    this->pBestFitness  = in.getInt();
 }
@@ -3,17 +3,23 @@
 
 #include <vector>
 #include <string>
+#include "Snapshot.h"
 // #include "NDPSO.h"
 using namespace std;
 
-// forward declaration because otherwise the compiler is NOT happy. At all. 
+// forward declaration because otherwise the compiler is NOT happy. At all.
 class NDPSO;
 
+// one particle's position and personal best, copied out of NDPSO's swarm buffers
+// the swarm itself isn't made of these (see NDPSO); the universal best is one, for the listener and best()
 class Particle {
 public:
     /* functions */
-    Particle(int, int, NDPSO*);
-    void update(const Particle&);
+    Particle() : fitness(0), pBestFitness(0), ndpso(nullptr) {}    // empty placeholder; assign a real Particle before use
+    Particle(NDPSO* ndpso) : fitness(0), pBestFitness(0), ndpso(ndpso) {}
+    void assign(const int*, int, const int*, int, int);
+    void save(SnapshotWriter&) const;
+    void load(SnapshotReader&, NDPSO*);
     vector<int> getCustomerAssignments();
     string getJSONFacilities();
     string getJSONCustomers();
@@ -23,11 +29,8 @@ public:
             int pBestFitness;
 
 private:
-    void updateSinglePosition(vector<int>&, int&, const float);
-    vector<int> exchange(const vector<int>&);
-
     /* members */
          NDPSO* ndpso;          // since nested classes don't work QUITE like I'd hoped, we need to save a reference to the enclosing NDPSO object
 };
 
-#endif
\ No newline at end of file
+#endif
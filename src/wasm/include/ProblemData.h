@@ -2,20 +2,350 @@
 #define PROBLEMDATA_H
 
 #include "defs.h"
+#include "Kernels.h"
+#include "Comparator.h"
+#include "ProblemDelta.h"
+#include "CoordinateCosts.h"
 #include <map>
+#include <climits>
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
 #include <algorithm>
 using namespace std;
 
+// customers per block in evaluateBounded(): long enough runs of each cost row to stream, short enough to stop soon after the cutoff
+const int BOUND_BLOCK = 128;
+
+/**
+ * How much work ProblemData::evaluateBounded() saved over evaluating every candidate in full
+ **/
+struct BoundStats {
+    long long evaluations = 0;          // bounded evaluations made
+    long long cutoffs = 0;              // how many of them stopped early
+    long long customersSkipped = 0;     // customers the early stops never looked at
+
+    void add(int scanned, int numCustomers) {
+        this->evaluations++;
+        if (scanned < numCustomers) {
+            this->cutoffs++;
+            this->customersSkipped += numCustomers - scanned;
+        }
+    }
+    void add(const BoundStats& other) {
+        this->evaluations      += other.evaluations;
+        this->cutoffs          += other.cutoffs;
+        this->customersSkipped += other.customersSkipped;
+    }
+    string getJSON() const {
+        return "{evaluations: " + to_string(this->evaluations) + ", cutoffs: " + to_string(this->cutoffs) +
+               ", customersSkipped: " + to_string(this->customersSkipped) + "}";
+    }
+};
+
+/**
+ * Read-only views of the cost storage, for loops templated on the view so the storage is picked once per call instead of once
+ * per cost (see ProblemData::getWideCosts() and the like): a matrix view's rows point straight into the int or int16_t buffer,
+ * so nothing is copied and a compact problem streams half the bytes, while an implicit problem's rows are computed
+ **/
+template<typename Cost>
+struct MatrixCosts {
+    const Cost* matrix;
+    int n;          // row length, the number of customers
+
+    const Cost* row(int fac) const { return this->matrix + fac * this->n; }
+    int cost(int cust, int fac) const { return this->matrix[fac * this->n + cust]; }
+};
+
+struct ImplicitCosts {
+    const CoordinateCosts* coordinates;
+
+    // computed into per-thread scratch, so it's only valid until the next row()
+    const int* row(int fac) const {
+        static thread_local vector<int> scratch;
+        scratch.resize(this->coordinates->size());
+        this->coordinates->fillRow(fac, scratch.data());
+        return scratch.data();
+    }
+    int cost(int cust, int fac) const { return this->coordinates->cost(cust, fac); }
+};
+
 // structure for holding data about the problem
+// the cost matrix is stored as a flat, facility-major buffer (costs[fac * numCustomers + cust])
+// so that one facility's costs to every customer are contiguous and can be written in place from JS.
+// facilities are picked from numCandidates candidate sites (0 .. numCandidates - 1), so the matrix is numCandidates x numCustomers;
+// most instances are square (every customer is also a candidate), but e.g. a few sites serving many demand points needn't be
+// demand is one weight per customer: STAR measures sum demand[cust] * cost, while RADIUS and RAY ignore it
+// the buffers are shared, so copying a ProblemData (into an Algorithm, an ALNSSolution, ...) is cheap
+// problems given by coordinates can skip the matrices entirely (allocateCoordinates()); their costs are computed on the fly,
+// and a matrix whose costs all fit in 16 bits can be stored at half the size (compact()).
+// everything that reads costs (getCost(), getCostRow(), assignCustomers(), evaluate()) works the same whichever way they're held
 struct ProblemData {
     string name;
     ProblemType type;
-    int numFacilities;
-    int numCustomers;
-    vector<vector<int>> costs;
-    vector<vector<int>> demand;
+    int numFacilities = 0;
+    int numCustomers  = 0;
+    int numCandidates = 0;
+    shared_ptr<vector<int>> costs;
+    shared_ptr<vector<int16_t>> narrowCosts;    // set instead of costs once compact() finds every cost fits in 16 bits
+    shared_ptr<vector<int>> demand;             // per customer
+    shared_ptr<CoordinateCosts> coordinates;    // only set for implicit problems, which have no cost buffer
+
+    /**
+     * Allocates fresh cost/demand buffers for the given number of customers (each also a candidate site)
+     * Costs start at 0 and every customer's demand starts at 1
+     * Any other ProblemData still holding the old buffers keeps them
+     *
+     * @param int numCustomers
+     * @return void
+     **/
+    void allocate(int numCustomers) {
+        this->allocate(numCustomers, numCustomers);
+    }
+
+    /**
+     * Allocates fresh buffers for a rectangular problem, with candidate sites separate from the customers
+     *
+     * @param int numCustomers
+     * @param int numCandidates
+     * @return void
+     **/
+    void allocate(int numCustomers, int numCandidates) {
+        this->numCustomers  = numCustomers;
+        this->numCandidates = numCandidates;
+        this->costs  = make_shared<vector<int>>(numCandidates * numCustomers, 0);
+        this->demand = make_shared<vector<int>>(numCustomers, 1);
+        this->narrowCosts = nullptr;
+        this->coordinates = nullptr;
+    }
+
+    /**
+     * Makes this an implicit problem over the given number of nodes, with coordinates starting at (0, 0)
+     * Only O(n) memory; costs come from the coordinates (see CoordinateCosts.h)
+     *
+     * @param int numCustomers
+     * @return void
+     **/
+    void allocateCoordinates(int numCustomers) {
+        this->numCustomers  = numCustomers;
+        this->numCandidates = numCustomers;
+        this->coordinates = make_shared<CoordinateCosts>();
+        this->coordinates->x.assign(numCustomers, 0.0);
+        this->coordinates->y.assign(numCustomers, 0.0);
+        this->costs  = nullptr;
+        this->narrowCosts = nullptr;
+        this->demand = make_shared<vector<int>>(numCustomers, 1);
+    }
+
+    bool isImplicit() const { return this->coordinates != nullptr; }
+    bool isSquare() const { return this->numCandidates == this->numCustomers; }
+    bool isCompact() const { return this->narrowCosts != nullptr; }
+
+    /**
+     * Switches the cost matrix to 16-bit storage if every cost fits, which halves the bytes evaluation streams through
+     * Called once a problem is loaded; any other ProblemData still holding the 32-bit buffer keeps it,
+     * so this one no longer sees (or makes) changes through it, e.g. a RoadNetwork's (see RoadNetwork::getData())
+     *
+     * @return bool whether the costs are now 16-bit
+     **/
+    bool compact() {
+        if (!this->costs) return this->isCompact();
+        for (int cost : *this->costs) {
+            if (cost < INT16_MIN || cost > INT16_MAX) return false;
+        }
+        this->narrowCosts = make_shared<vector<int16_t>>(this->costs->begin(), this->costs->end());
+        this->costs = nullptr;
+        return true;
+    }
+
+    // back to 32-bit storage, e.g. to write a cost that doesn't fit in 16 bits
+    void widen() {
+        if (!this->narrowCosts) return;
+        this->costs = make_shared<vector<int>>(this->narrowCosts->begin(), this->narrowCosts->end());
+        this->narrowCosts = nullptr;
+    }
+
+    // switches an implicit problem's metric (see CoordinateCosts.h); call it again after changing the coordinates
+    void setMetric(Metric metric) {
+        if (!this->coordinates) throw "ProblemData::setMetric(): only an implicit problem has coordinates!";
+        this->coordinates->setMetric(metric);
+    }
+
+    /**
+     * Turns an implicit problem into a matrix one with the same costs
+     * Worth it whenever the n x n matrix fits, since reading a cost row beats computing it
+     *
+     * @return void
+     **/
+    void materialize() {
+        if (!this->coordinates) return;
+        shared_ptr<CoordinateCosts> coordinates = this->coordinates;
+        this->allocate(this->numCustomers);
+        coordinates->fillMatrix(this->costs->data());
+    }
+
+    int getCost(int cust, int fac) const {
+        if (this->coordinates) return this->coordinates->cost(cust, fac);
+        if (this->narrowCosts) return (*this->narrowCosts)[fac * this->numCustomers + cust];
+        return (*this->costs)[fac * this->numCustomers + cust];
+    }
+    void setCost(int cust, int fac, int cost) {
+        if (this->coordinates) throw "ProblemData::setCost(): an implicit problem's costs come from its coordinates!";
+        if (this->narrowCosts) {
+            if (cost >= INT16_MIN && cost <= INT16_MAX) {
+                (*this->narrowCosts)[fac * this->numCustomers + cust] = cost;
+                return;
+            }
+            this->widen();
+        }
+        (*this->costs)[fac * this->numCustomers + cust] = cost;
+    }
+
+    // the cost storage as one of the views above; call whichever isImplicit() and isCompact() say the problem has
+    MatrixCosts<int>     getWideCosts() const     { return { this->costs->data(), this->numCustomers }; }
+    MatrixCosts<int16_t> getNarrowCosts() const   { return { this->narrowCosts->data(), this->numCustomers }; }
+    ImplicitCosts        getImplicitCosts() const { return { this->coordinates.get() }; }
+
+    // pointer to the costs from the given facility to every customer
+    // for an implicit or compact problem the row is written into per-thread scratch, so it's only valid until the next call;
+    // loops over many rows should take a view instead (see MatrixCosts)
+    const int* getCostRow(int fac) const {
+        if (this->coordinates || this->narrowCosts) {
+            static thread_local vector<int> row;
+            row.resize(this->numCustomers);
+            if (this->coordinates) {
+                this->coordinates->fillRow(fac, row.data());
+            } else {
+                const int16_t* narrow = this->narrowCosts->data() + fac * this->numCustomers;
+                copy(narrow, narrow + this->numCustomers, row.begin());
+            }
+            return row.data();
+        }
+        return this->costs->data() + fac * this->numCustomers;
+    }
+
+    /**
+     * Applies a set of changes to the problem (see ProblemDelta.h)
+     * Cost changes alone are written in place, in O(changes), so every copy sharing the buffers sees them;
+     * removing or adding nodes rebuilds the buffers and leaves any other ProblemData with the old ones
+     *
+     * @param const ProblemDelta& delta
+     * @return vector<int> newIndex: newIndex[oldCandidate] is where the candidate ended up, or -1 if it was removed
+     **/
+    vector<int> applyDelta(const ProblemDelta& delta) {
+        if (this->coordinates && (delta.changesNodes() || !delta.costs.empty())) {
+            throw "ProblemData::applyDelta(): an implicit problem can only change its number of facilities!";
+        }
+        if (!this->isSquare() && delta.changesNodes()) {
+            throw "ProblemData::applyDelta(): nodes can only be added to or removed from a square problem!";
+        }
+        int n = this->numCustomers;     // (nodes only change when square, so n is numCandidates too whenever it's used below)
+        vector<int> newIndex (this->numCandidates);
+        for (int fac = 0; fac < this->numCandidates; fac++) {
+            newIndex[fac] = fac;
+        }
+
+        if (delta.changesNodes()) {
+            for (int node : delta.removed) {
+                if (node < 0 || node >= n) throw "ProblemData::applyDelta(): removed node out of range!";
+                newIndex[node] = -1;
+            }
+            vector<int> kept;
+            for (int node = 0; node < n; node++) {
+                if (newIndex[node] != -1) {
+                    newIndex[node] = kept.size();
+                    kept.push_back(node);
+                }
+            }
+
+            int m = kept.size() + delta.added.size();
+            auto newCosts  = make_shared<vector<int>>(m * m, 0);
+            auto newDemand = make_shared<vector<int>>(m, 1);
+            for (int fac = 0; fac < (int) kept.size(); fac++) {
+                for (int cust = 0; cust < (int) kept.size(); cust++) {
+                    (*newCosts)[fac * m + cust] = this->getCost(kept[cust], kept[fac]);
+                }
+                (*newDemand)[fac] = (*this->demand)[kept[fac]];
+            }
+            for (int i = 0; i < (int) delta.added.size(); i++) {
+                const vector<int>& row = delta.added[i];
+                if ((int) row.size() != m) throw "ProblemData::applyDelta(): an added node needs a cost to every node!";
+                int node = kept.size() + i;
+                for (int other = 0; other < m; other++) {
+                    (*newCosts)[node * m + other] = row[other];
+                    (*newCosts)[other * m + node] = row[other];
+                }
+            }
+            bool wasCompact = this->isCompact();
+            this->numCustomers  = m;
+            this->numCandidates = m;
+            this->costs  = newCosts;
+            this->narrowCosts = nullptr;
+            this->demand = newDemand;
+            if (wasCompact) this->compact();
+        }
+
+        for (const CostChange& change : delta.costs) {
+            if (change.cust < 0 || change.cust >= this->numCustomers || change.fac < 0 || change.fac >= this->numCandidates) {
+                throw "ProblemData::applyDelta(): cost change out of range!";
+            }
+            this->setCost(change.cust, change.fac, change.cost);
+        }
+        if (delta.numFacilities > 0) {
+            this->numFacilities = delta.numFacilities;
+        }
+        if (this->numFacilities > this->numCandidates) throw "ProblemData::applyDelta(): more facilities than candidates!";
+        return newIndex;
+    }
+
+    /**
+     * Greedily opens or closes facilities until exactly numFacilities are open
+     * Opens whichever facility improves the objective most, or closes whichever hurts it least,
+     * so a solution to a slightly different problem becomes a good starting point for this one
+     *
+     * @param vector<int> facilities (distinct, in range)
+     * @return vector<int> facilities
+     **/
+    vector<int> fitFacilities(vector<int> facilities) const {
+        Comparator comparator (this->type.objective);
+        vector<bool> open (this->numCandidates, false);
+        for (int fac : facilities) {
+            open[fac] = true;
+        }
+
+        while ((int) facilities.size() < this->numFacilities) {
+            int bestFac = -1, bestObjective = 0;
+            for (int fac = 0; fac < this->numCandidates; fac++) {
+                if (open[fac]) continue;
+                facilities.push_back(fac);
+                int objective = this->evaluate(facilities);
+                facilities.pop_back();
+                if (bestFac == -1 || comparator(objective, bestObjective)) {
+                    bestFac = fac;
+                    bestObjective = objective;
+                }
+            }
+            facilities.push_back(bestFac);
+            open[bestFac] = true;
+        }
+
+        vector<int> without;
+        while ((int) facilities.size() > this->numFacilities) {
+            int bestSlot = -1, bestObjective = 0;
+            for (int slot = 0; slot < (int) facilities.size(); slot++) {
+                without = facilities;
+                without.erase(without.begin() + slot);
+                int objective = this->evaluate(without);
+                if (bestSlot == -1 || comparator(objective, bestObjective)) {
+                    bestSlot = slot;
+                    bestObjective = objective;
+                }
+            }
+            facilities.erase(facilities.begin() + bestSlot);
+        }
+        return facilities;
+    }
 
     /**
      * Calculates objective value for given customer assignments
@@ -23,12 +353,12 @@ struct ProblemData {
      * @param const vector<int> assignments,
      * @return int objective
      **/
-    int calcObjective(const vector<int> assignments) {
+    int calcObjective(const vector<int>& assignments) {
         map<int, int> measures = this->getMeasures(assignments);
         return this->getAggregate(measures);
     }
 
-    map<int, int> getMeasures(const vector<int> assignments) {
+    map<int, int> getMeasures(const vector<int>& assignments) {
         switch (this->type.measure) {
             case STAR:
                 return this->calcStars(assignments);
@@ -41,7 +371,7 @@ struct ProblemData {
         }
     }
 
-    int getAggregate(const map<int, int> measures) {
+    int getAggregate(const map<int, int>& measures) {
         switch (this->type.aggregate) {
             case MAX:
                 return this->getMax(measures);
@@ -54,87 +384,251 @@ struct ProblemData {
         }
     }
 
-    map<int, int> calcStars(const vector<int> assignments) {
+    map<int, int> calcStars(const vector<int>& assignments) {
         map<int, int> stars;
-        for (int cust = 0; cust < assignments.size(); cust++) {
+        for (int cust = 0; cust < (int) assignments.size(); cust++) {
             int fac = assignments[cust];
             if (stars.count(fac) == 0) {
                 stars[fac] = 0;
             }
-            stars[fac] += this->costs[cust][fac];
+            stars[fac] = Kernels::saturate(stars[fac] + (long long) (*this->demand)[cust] * this->getCost(cust, fac));
         }
         return stars;
     }
 
-    map<int, int> calcRadii(const vector<int> assignments) {
+    map<int, int> calcRadii(const vector<int>& assignments) {
         map<int, int> radii;
-        for (int cust = 0; cust < assignments.size(); cust++) {
+        for (int cust = 0; cust < (int) assignments.size(); cust++) {
             int fac = assignments[cust];
-            if (radii.count(fac) == 0 || costs[cust][fac] > radii[fac]) {
-                radii[fac] = this->costs[cust][fac];
+            int cost = this->getCost(cust, fac);
+            if (radii.count(fac) == 0 || cost > radii[fac]) {
+                radii[fac] = cost;
             }
         }
         return radii;
     }
 
-    map<int, int> calcRays(const vector<int> assignments) {
+    map<int, int> calcRays(const vector<int>& assignments) {
         map<int, int> rays;
-        for (int cust = 0; cust < assignments.size(); cust++) {
+        for (int cust = 0; cust < (int) assignments.size(); cust++) {
             int fac = assignments[cust];
-            if (rays.count(fac) == 0 || costs[cust][fac] < rays[fac]) {
-                rays[fac] = costs[cust][fac];
+            int cost = this->getCost(cust, fac);
+            if (rays.count(fac) == 0 || cost < rays[fac]) {
+                rays[fac] = cost;
             }
         }
         return rays;
     }
 
-    int getMax(const map<int, int> measures) {
+    int getMax(const map<int, int>& measures) {
         return max_element(measures.begin(), measures.end(),
             [](pair<int, int> left, pair<int, int> right) { 
                 return left.second < right.second; 
             })->second;
     }
 
-    int getMin(const map<int, int> measures) {
+    int getMin(const map<int, int>& measures) {
         return min_element(measures.begin(), measures.end(),
             [](pair<int, int> left, pair<int, int> right) { 
                 return left.second < right.second; 
             })->second;
     }
 
-    int getSum(const map<int, int> measures) {
-        int sum = 0;
+    int getSum(const map<int, int>& measures) {
+        long long sum = 0;
         for (auto pair : measures) {
             sum += pair.second;
         }
-        return sum;
+        return Kernels::saturate(sum);
     }
 
     /**
      * Assigns customers to their closest facility
+     * Folds in one facility's cost row at a time with the nearest-facility kernel, so the matrix is streamed contiguously;
+     * ties go to the facility that comes first in the facilities vector
      *
-     * @param const vector<int> facilities
+     * @param const vector<int>& facilities
      * @return vector<int> customerAssignments
      **/
-    vector<int> assignCustomers(const vector<int> facilities) {
-        vector<int> customerAssignments;
-        for (int cust = 0; cust < this->costs.size(); cust++) {
-            int bestFac  = facilities[0];
-            int bestCost = this->costs[cust][bestFac];
-            for (int facIdx = 1; facIdx < facilities.size(); facIdx++) {
-                int fac = facilities[facIdx];
-                int newCost = this->costs[cust][fac];
-                if (newCost < bestCost) {
-                    bestCost = newCost;
-                    bestFac  = fac; 
+    vector<int> assignCustomers(const vector<int>& facilities) const {
+        vector<int> customerAssignments (this->numCustomers), bestCosts (this->numCustomers);
+        this->nearest(facilities, bestCosts.data(), customerAssignments.data());
+        for (int& slot : customerAssignments) {
+            slot = facilities[slot];
+        }
+        return customerAssignments;
+    }
+
+    /**
+     * Calculates the objective of an open facility set straight from the kernels, without building a measures map
+     * Gives the same value as calcObjective(assignCustomers(facilities)); measures and sums too big for an int saturate to INT_MAX
+     * Scratch space is per thread, so this is safe to call concurrently
+     *
+     * @param const vector<int>& facilities
+     * @param vector<int>* assignments: if given, filled with the customer assignments as well
+     * @return int objective
+     **/
+    int evaluate(const vector<int>& facilities, vector<int>* assignments = nullptr) const {
+        static thread_local vector<int> bestCosts, slots;
+        int n = this->numCustomers;
+
+        // nearest facility per customer, as a slot in the facilities vector
+        bestCosts.resize(n);
+        slots.resize(n);
+        this->nearest(facilities, bestCosts.data(), slots.data());
+        return this->aggregate(facilities, bestCosts.data(), slots.data(), assignments);
+    }
+
+    /**
+     * Whether evaluateBounded() can stop early on this problem: when minimizing the sum or the max of stars or radii,
+     * the measures only grow as customers are added, so the customers seen so far give a lower bound on the objective
+     * (costs and demand are assumed non-negative, as every reader produces them). Implicit problems are always evaluated in full
+     *
+     * @return bool
+     **/
+    bool isBoundable() const {
+        return this->type.objective == MINIMIZE && this->type.aggregate != MIN && this->type.measure != RAY && !this->coordinates;
+    }
+
+    /**
+     * Like evaluate(), but gives up as soon as the objective is proven worse than cutoff
+     * Customers go a block at a time, with a running lower bound checked after each block (see isBoundable());
+     * a value worse than cutoff only ever says that, while a value no worse than it is always the exact objective
+     *
+     * @param const vector<int>& facilities
+     * @param int cutoff
+     * @param vector<int>* assignments: if given, filled with the customer assignments (only if it didn't give up)
+     * @param int* scanned: if given, set to the number of customers looked at (numCustomers unless it gave up)
+     * @return int objective, or a lower bound on it that's worse than cutoff
+     **/
+    int evaluateBounded(const vector<int>& facilities, int cutoff, vector<int>* assignments = nullptr, int* scanned = nullptr) const {
+        static thread_local vector<int> bestCosts, slots;
+        static thread_local vector<long long> partial;
+        int n = this->numCustomers;
+        int p = facilities.size();
+        if (scanned != nullptr) *scanned = n;
+        if (!this->isBoundable()) {
+            return this->evaluate(facilities, assignments);
+        }
+
+        bestCosts.resize(n);
+        slots.resize(n);
+        partial.assign(p, 0);
+        const int* weights = this->demand->data();
+        long long bound = 0;
+        for (int from = 0; from < n; from += BOUND_BLOCK) {
+            int to = min(n, from + BOUND_BLOCK);
+            if (this->narrowCosts) {
+                nearestInMatrix(this->narrowCosts->data(), n, facilities, bestCosts.data(), slots.data(), from, to);
+            } else {
+                nearestInMatrix(this->costs->data(), n, facilities, bestCosts.data(), slots.data(), from, to);
+            }
+
+            // partial stars/radii, and the aggregate of them so far; the sum of stars and the max radius don't need them per facility
+            if (this->type.measure == STAR && this->type.aggregate == SUM) {
+                bound += Kernels::dot(bestCosts.data() + from, weights + from, to - from);
+            } else if (this->type.measure == RADIUS && this->type.aggregate == MAX) {
+                bound = max(bound, (long long) Kernels::max(bestCosts.data() + from, to - from));
+            } else for (int cust = from; cust < to; cust++) {
+                int slot = slots[cust];
+                long long grown = (this->type.measure == STAR ? partial[slot] + (long long) weights[cust] * bestCosts[cust] : max(partial[slot], (long long) bestCosts[cust]));
+                if (this->type.aggregate == SUM) {
+                    bound += grown - partial[slot];
+                } else {
+                    bound = max(bound, grown);
                 }
+                partial[slot] = grown;
+            }
+            if (bound > cutoff && to < n) {
+                if (scanned != nullptr) *scanned = to;
+                return (int) min(bound, (long long) INT_MAX);
             }
-            customerAssignments.push_back(bestFac);
         }
-        return customerAssignments;
+        return this->aggregate(facilities, bestCosts.data(), slots.data(), assignments);
+    }
+
+    // every customer's cheapest open facility, as a slot in the facilities vector; the storage is picked once per call
+    void nearest(const vector<int>& facilities, int* bestCosts, int* slots) const {
+        if (this->coordinates) {
+            this->coordinates->nearest(facilities, bestCosts, slots);
+        } else if (this->narrowCosts) {
+            nearestInMatrix(this->narrowCosts->data(), this->numCustomers, facilities, bestCosts, slots);
+        } else {
+            nearestInMatrix(this->costs->data(), this->numCustomers, facilities, bestCosts, slots);
+        }
     }
 
+private:
+    // the objective from every customer's nearest slot and its cost (see evaluate())
+    int aggregate(const vector<int>& facilities, const int* bestCosts, const int* slots, vector<int>* assignments) const {
+        static thread_local vector<int> measures, counts;
+        static thread_local vector<long long> stars;
+        int n = this->numCustomers;
+        int p = facilities.size();
+        if (assignments != nullptr) {
+            assignments->resize(n);
+            for (int cust = 0; cust < n; cust++) {
+                (*assignments)[cust] = facilities[slots[cust]];
+            }
+        }
+
+        // every customer's cost lands in exactly one star, so the sum of stars is just the demand-weighted sum of the best costs
+        const int* weights = this->demand->data();
+        if (this->type.measure == STAR && this->type.aggregate == SUM) {
+            return Kernels::saturate(Kernels::dot(bestCosts, weights, n));
+        }
+
+        // per-facility measures
+        counts.assign(p, 0);
+        switch (this->type.measure) {
+            case STAR:
+                stars.assign(p, 0);
+                for (int cust = 0; cust < n; cust++) { stars[slots[cust]] += (long long) weights[cust] * bestCosts[cust]; counts[slots[cust]]++; }
+                measures.resize(p);
+                for (int slot = 0; slot < p; slot++) measures[slot] = Kernels::saturate(stars[slot]);
+                break;
+            case RADIUS:
+                measures.assign(p, INT_MIN);
+                for (int cust = 0; cust < n; cust++) { measures[slots[cust]] = max(measures[slots[cust]], bestCosts[cust]); counts[slots[cust]]++; }
+                break;
+            case RAY:
+                measures.assign(p, INT_MAX);
+                for (int cust = 0; cust < n; cust++) { measures[slots[cust]] = min(measures[slots[cust]], bestCosts[cust]); counts[slots[cust]]++; }
+                break;
+            default:
+                throw "Unsupported problem type!";
+        }
+
+        // facilities without customers have no measure, so make sure they can't affect the aggregate
+        int empty = (this->type.aggregate == MAX ? INT_MIN : (this->type.aggregate == MIN ? INT_MAX : 0));
+        for (int slot = 0; slot < p; slot++) {
+            if (counts[slot] == 0) measures[slot] = empty;
+        }
+        switch (this->type.aggregate) {
+            case MAX:
+                return Kernels::max(measures.data(), p);
+            case MIN:
+                return Kernels::min(measures.data(), p);
+            case SUM:
+                return Kernels::saturate(Kernels::sum(measures.data(), p));
+            default:
+                throw "Unsupported problem type!";
+        }
+    }
 
+    // nearest() over the matrix, for customers [from, to) (all of them by default)
+    template<typename Cost>
+    static void nearestInMatrix(const Cost* matrix, int n, const vector<int>& facilities, int* bestCosts, int* slots, int from = 0, int to = -1) {
+        if (to < 0) to = n;
+        const Cost* row = matrix + facilities[0] * n;
+        for (int cust = from; cust < to; cust++) {
+            bestCosts[cust] = row[cust];
+            slots[cust] = 0;
+        }
+        for (int slot = 1; slot < (int) facilities.size(); slot++) {
+            Kernels::nearestUpdate(matrix + facilities[slot] * n + from, bestCosts + from, slots + from, slot, to - from);
+        }
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef PROBLEMDELTA_H
+#define PROBLEMDELTA_H
+
+#include <vector>
+using namespace std;
+
+struct CostChange {
+    int cust;
+    int fac;
+    int cost;
+};
+
+// structure for describing how a problem changed since it was last solved (see ProblemData::applyDelta())
+// nodes are removed first, then added to the end, then costs are changed,
+// so cost changes use the node numbers of the changed problem and can touch the added nodes
+struct ProblemDelta {
+    vector<int> removed;            // old node numbers
+    vector<vector<int>> added;      // one row per new node: its cost to (and from) every node of the changed problem
+    vector<CostChange> costs;       // single entries; symmetric problems need both directions
+    int numFacilities = 0;          // new p; 0 keeps the old one
+
+    void removeNode(int node) { this->removed.push_back(node); }
+    void addNode(const vector<int>& costs) { this->added.push_back(costs); }
+    void changeCost(int cust, int fac, int cost) { this->costs.push_back({ cust, fac, cost }); }
+    bool changesNodes() const { return !this->removed.empty() || !this->added.empty(); }
+};
+
+#endif
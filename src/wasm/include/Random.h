@@ -0,0 +1,40 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+#include <cstdlib>
+using namespace std;
+
+/**
+ * Small xorshift64* generator
+ * Each Algorithm owns one, so runs on different threads don't fight over rand()
+ * and a fixed seed reproduces a run exactly. The whole state is one integer.
+ **/
+class Random {
+public:
+    // seeds from rand() so callers that only srand() still get varied runs
+    Random() { this->seed(((uint64_t)rand() << 32) ^ (uint64_t)rand()); }
+    Random(uint64_t seed) { this->seed(seed); }
+
+    void seed(uint64_t seed) { this->state = (seed != 0 ? seed : 0x9E3779B97F4A7C15ULL); }
+    uint64_t getState() { return this->state; }
+    void     setState(uint64_t state) { this->state = state; }
+
+    uint64_t next() {
+        this->state ^= this->state >> 12;
+        this->state ^= this->state << 25;
+        this->state ^= this->state >> 27;
+        return this->state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // uniform integer in [0, bound)
+    int nextInt(int bound) { return (int)(((next() >> 32) * (uint64_t)bound) >> 32); }
+
+    // uniform float in [0, 1)
+    float nextFloat() { return (next() >> 40) * (1.0f / 16777216.0f); }
+
+private:
+    uint64_t state;
+};
+
+#endif
@@ -0,0 +1,259 @@
+#include "RoadNetwork.h"
+
+#include <map>
+#include <queue>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include "ProblemData.h"
+#include "ProblemDelta.h"
+using namespace std;
+
+/**
+ * Constructor for a network of the given number of nodes and no edges yet
+ * Add the edges with addEdge(), then call computeAllPairs() once
+ *
+ * @param int numNodes
+ **/
+RoadNetwork::RoadNetwork(int numNodes) {
+    this->data.allocate(numNodes);
+    this->adjacency.resize(numNodes);
+}
+
+/**
+ * Adds (or re-weights) an edge without touching the distances; for building the network before computeAllPairs()
+ * A repeated edge keeps the last weight given
+ *
+ * @param int node1 (0-indexed)
+ * @param int node2 (0-indexed)
+ * @param int weight
+ * @return void
+ **/
+void RoadNetwork::addEdge(int node1, int node2, int weight) {
+    if (node1 < 0 || node2 < 0 || node1 >= this->data.numCustomers || node2 >= this->data.numCustomers || node1 == node2) {
+        throw "RoadNetwork::addEdge(): invalid edge!";
+    }
+    if (weight < 0) throw "RoadNetwork::addEdge(): negative weight!";
+
+    pair<int, int> key = minmax(node1, node2);
+    if (this->weights.count(key) > 0) {
+        for (auto& edge : this->adjacency[node1]) { if (edge.first == node2) edge.second = weight; }
+        for (auto& edge : this->adjacency[node2]) { if (edge.first == node1) edge.second = weight; }
+    } else {
+        this->adjacency[node1].push_back({ node2, weight });
+        this->adjacency[node2].push_back({ node1, weight });
+    }
+    this->weights[key] = weight;
+}
+
+/**
+ * Returns the weight of an edge, or -1 if there's no such edge
+ *
+ * @param int node1
+ * @param int node2
+ * @return int weight
+ **/
+int RoadNetwork::getEdge(int node1, int node2) {
+    auto it = this->weights.find(minmax(node1, node2));
+    return (it == this->weights.end() ? -1 : it->second);
+}
+
+/**
+ * Fills the cost matrix with all-pairs shortest paths, one Dijkstra per node
+ * O(n m log n), which for road-like graphs (m ~ n) beats Floyd-Warshall's O(n^3) comfortably
+ *
+ * @return void
+ **/
+void RoadNetwork::computeAllPairs() {
+    int n = this->data.numCustomers;
+    vector<int> dist;
+    this->data.widen();     // every cost is rewritten, and an unreachable pair doesn't fit in 16 bits anyway
+    for (int source = 0; source < n; source++) {
+        this->dijkstra(source, dist);
+        copy(dist.begin(), dist.end(), this->data.costs->begin() + source * n);
+    }
+    this->changes = ProblemDelta();
+}
+
+/**
+ * Changes (or adds) an edge and updates the shortest paths it affects
+ *
+ * @param int node1
+ * @param int node2
+ * @param int weight
+ * @return void
+ **/
+void RoadNetwork::setEdge(int node1, int node2, int weight) {
+    int old = this->getEdge(node1, node2);
+    this->addEdge(node1, node2, weight);
+    if (old == -1 || weight < old) {
+        this->decrease(node1, node2, weight);
+    } else if (weight > old) {
+        this->increase(node1, node2, old);
+    }
+}
+
+/**
+ * Removes an edge and updates the shortest paths that ran over it
+ *
+ * @param int node1
+ * @param int node2
+ * @return void
+ **/
+void RoadNetwork::removeEdge(int node1, int node2) {
+    int old = this->getEdge(node1, node2);
+    if (old == -1) throw "RoadNetwork::removeEdge(): no such edge!";
+
+    this->weights.erase(minmax(node1, node2));
+    auto drop = [](vector<pair<int, int>>& edges, int neighbor) {
+        edges.erase(remove_if(edges.begin(), edges.end(), [&](const pair<int, int>& edge) { return edge.first == neighbor; }), edges.end());
+    };
+    drop(this->adjacency[node1], node2);
+    drop(this->adjacency[node2], node1);
+    this->increase(node1, node2, old);
+}
+
+/**
+ * Returns the customers whose nearest open facility might have changed since the last takeDelta(),
+ * i.e. those whose distance to at least one of the given facilities changed
+ *
+ * @param const vector<int>& facilities
+ * @return vector<int> customers
+ **/
+vector<int> RoadNetwork::getAffectedCustomers(const vector<int>& facilities) {
+    vector<bool> open (this->data.numCustomers, false);
+    vector<bool> affected (this->data.numCustomers, false);
+    for (int fac : facilities) {
+        open[fac] = true;
+    }
+    for (const CostChange& change : this->changes.costs) {
+        if (open[change.fac]) {
+            affected[change.cust] = true;
+        }
+    }
+
+    vector<int> customers;
+    for (int cust = 0; cust < this->data.numCustomers; cust++) {
+        if (affected[cust]) customers.push_back(cust);
+    }
+    return customers;
+}
+
+/**
+ * Returns every cost change since the last call, and starts recording afresh
+ * The costs have already been written (getData() shares them), so applying the delta again is harmless
+ *
+ * @return ProblemDelta
+ **/
+ProblemDelta RoadNetwork::takeDelta() {
+    ProblemDelta delta = this->changes;
+    this->changes = ProblemDelta();
+    return delta;
+}
+
+/**
+ * Updates the distances after edge (u, v) got cheaper (or appeared)
+ * A new shortest path can use the edge at most once, so every improved pair is s -> u -> v -> t (or s -> v -> u -> t)
+ * over the OLD distances, and only sources that now reach u or v faster through the edge can improve at all
+ *
+ * @param int u
+ * @param int v
+ * @param int weight
+ * @return void
+ **/
+void RoadNetwork::decrease(int u, int v, int weight) {
+    int n = this->data.numCustomers;
+    const int* costs = this->data.getCostRow(u);    // (copied right away: a compact problem's row is only scratch)
+    vector<int> fromU (costs, costs + n);
+    costs = this->data.getCostRow(v);
+    vector<int> fromV (costs, costs + n);
+
+    for (int s = 0; s < n; s++) {
+        int toV = fromU[s] + weight;    // s -> u -> v
+        int toU = fromV[s] + weight;    // s -> v -> u
+        if (toV >= fromV[s] && toU >= fromU[s]) continue;
+
+        for (int t = 0; t < n; t++) {
+            int cost = min(toV + fromV[t], toU + fromU[t]);
+            if (cost < this->data.getCost(t, s)) {
+                this->recordChange(s, t, cost);
+            }
+        }
+    }
+}
+
+/**
+ * Updates the distances after edge (u, v) got more expensive (or disappeared)
+ * Only pairs whose every shortest path used the edge can change, and their sources are exactly the nodes
+ * for which the edge was tight (d(s, u) + old == d(s, v) or the reverse); those sources get a fresh Dijkstra
+ *
+ * @param int u
+ * @param int v
+ * @param int old: the edge's previous weight
+ * @return void
+ **/
+void RoadNetwork::increase(int u, int v, int old) {
+    int n = this->data.numCustomers;
+    vector<int> sources;
+    for (int s = 0; s < n; s++) {
+        int toU = this->data.getCost(u, s);
+        int toV = this->data.getCost(v, s);
+        if (toU < UNREACHABLE && toV < UNREACHABLE && (toU + old == toV || toV + old == toU)) {
+            sources.push_back(s);
+        }
+    }
+
+    vector<int> dist;
+    for (int s : sources) {
+        this->dijkstra(s, dist);
+        for (int t = 0; t < n; t++) {
+            if (dist[t] != this->data.getCost(t, s)) {
+                this->recordChange(s, t, dist[t]);
+            }
+        }
+    }
+}
+
+/**
+ * Single-source shortest paths over the current edges
+ *
+ * @param int source
+ * @param vector<int>& dist: filled with the distance to every node (UNREACHABLE if there's no path)
+ * @return void
+ **/
+void RoadNetwork::dijkstra(int source, vector<int>& dist) {
+    dist.assign(this->data.numCustomers, UNREACHABLE);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> queue;
+    dist[source] = 0;
+    queue.push({ 0, source });
+    while (!queue.empty()) {
+        pair<int, int> top = queue.top();
+        queue.pop();
+        if (top.first > dist[top.second]) continue;
+        for (const pair<int, int>& edge : this->adjacency[top.second]) {
+            int cost = top.first + edge.second;
+            if (cost < dist[edge.first]) {
+                dist[edge.first] = cost;
+                queue.push({ cost, edge.first });
+            }
+        }
+    }
+}
+
+/**
+ * Writes a changed distance in both directions and records it for takeDelta()
+ *
+ * @param int s
+ * @param int t
+ * @param int cost
+ * @return void
+ **/
+void RoadNetwork::recordChange(int s, int t, int cost) {
+    this->data.setCost(t, s, cost);
+    this->data.setCost(s, t, cost);
+    this->changes.changeCost(t, s, cost);
+    if (s != t) {
+        this->changes.changeCost(s, t, cost);
+    }
+}
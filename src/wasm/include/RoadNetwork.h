@@ -0,0 +1,54 @@
+#ifndef ROADNETWORK_H
+#define ROADNETWORK_H
+
+#include <map>
+#include <climits>
+#include <vector>
+#include <string>
+#include <utility>
+#include "ProblemData.h"
+#include "ProblemDelta.h"
+using namespace std;
+
+// distance between nodes that no path connects; small enough that two of them plus an edge can't overflow
+const int UNREACHABLE = INT_MAX / 4;
+
+/**
+ * A problem backed by the undirected, weighted graph its costs come from (e.g. an ORLIB edge list)
+ * The costs are the graph's all-pairs shortest paths, and they're kept up to date as edges change:
+ *     + a decrease only touches the pairs that the edge now shortcuts
+ *     + an increase (or removal) only re-runs Dijkstra from the sources whose shortest paths ran over the edge
+ * Every cost that changes is recorded until takeDelta(), so a solver can be pointed at just what moved
+ * (see Algorithm::reoptimize() and getAffectedCustomers()).
+ **/
+class RoadNetwork {
+public:
+    RoadNetwork() {}
+    RoadNetwork(int numNodes);
+
+    void addEdge(int, int, int);
+    void computeAllPairs();
+    void setEdge(int, int, int);
+    void removeEdge(int, int);
+    int  getEdge(int, int);
+    int  getNumEdges() { return this->weights.size(); }
+
+    // shares this network's cost buffer, so it sees every later change, unless either side is compact()ed (or widened to fit
+    // a cost) after this: that gives it a buffer of its own, and from then on it only sees what takeDelta() hands over
+    ProblemData getData() { return this->data; }
+    ProblemData& getDataRef() { return this->data; }
+    vector<int> getAffectedCustomers(const vector<int>&);
+    ProblemDelta takeDelta();
+private:
+    void decrease(int, int, int);
+    void increase(int, int, int);
+    void dijkstra(int, vector<int>&);
+    void recordChange(int, int, int);
+
+    ProblemData data;
+    vector<vector<pair<int, int>>> adjacency;   // node -> (neighbor, weight)
+    map<pair<int, int>, int> weights;           // (smaller node, larger node) -> weight
+    ProblemDelta changes;                       // costs changed since the last takeDelta()
+};
+
+#endif
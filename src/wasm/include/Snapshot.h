@@ -0,0 +1,108 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <zlib.h>
+using namespace std;
+
+/**
+ * Byte format for checkpoints (see Algorithm::checkpoint())
+ *     "CDFC", u32 version, u32 rawLength, zlib-deflated body
+ * The body is whatever the writer was given, in order: fixed-width little-endian numbers,
+ * floats as their raw bits (so a resumed search continues bit-exactly), and length-prefixed strings/vectors
+ **/
+// 2: the problem fingerprint includes numCandidates; 3: ALNS names its functions and saves their statistics;
+// 4: ALNS saves each destroy function's fraction of p
+const uint32_t SNAPSHOT_VERSION = 4;
+
+class SnapshotWriter {
+public:
+    void putInt(int32_t value) { this->putRaw(&value, 4); }
+    void putUint64(uint64_t value) { this->putRaw(&value, 8); }
+    void putFloat(float value) { this->putRaw(&value, 4); }
+    void putString(const string& value) {
+        this->putInt(value.size());
+        this->body += value;
+    }
+    void putVector(const vector<int>& values) {
+        this->putInt(values.size());
+        this->putRaw(values.data(), values.size() * 4);
+    }
+
+    /**
+     * Compresses everything written so far into a finished snapshot
+     *
+     * @return string bytes
+     **/
+    string finish() {
+        uLongf compressedLength = compressBound(this->body.size());
+        string compressed (compressedLength, '\0');
+        if (compress2((Bytef*)&compressed[0], &compressedLength, (const Bytef*)this->body.data(), this->body.size(), 6) != Z_OK) {
+            throw "SnapshotWriter::finish(): compression failed!";
+        }
+        compressed.resize(compressedLength);
+
+        string out = "CDFC";
+        uint32_t header[2] = { SNAPSHOT_VERSION, (uint32_t)this->body.size() };
+        out.append((const char*)header, 8);
+        return out + compressed;
+    }
+private:
+    void putRaw(const void* bytes, size_t length) { this->body.append((const char*)bytes, length); }
+
+    string body;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const string& bytes) {
+        if (bytes.size() < 12 || bytes.compare(0, 4, "CDFC") != 0) throw "SnapshotReader::SnapshotReader(): not a checkpoint!";
+        uint32_t header[2];
+        memcpy(header, bytes.data() + 4, 8);
+        if (header[0] != SNAPSHOT_VERSION) throw "SnapshotReader::SnapshotReader(): unsupported checkpoint version!";
+
+        uLongf rawLength = header[1];
+        this->body.assign(rawLength, '\0');
+        if (uncompress((Bytef*)&this->body[0], &rawLength, (const Bytef*)bytes.data() + 12, bytes.size() - 12) != Z_OK
+                || rawLength != this->body.size()) {
+            throw "SnapshotReader::SnapshotReader(): corrupt checkpoint!";
+        }
+    }
+
+    int32_t  getInt() { int32_t value; this->getRaw(&value, 4); return value; }
+    uint64_t getUint64() { uint64_t value; this->getRaw(&value, 8); return value; }
+    float    getFloat() { float value; this->getRaw(&value, 4); return value; }
+    string getString() {
+        size_t length = this->getLength(1);
+        string value = this->body.substr(this->pos, length);
+        this->pos += length;
+        return value;
+    }
+    vector<int> getVector() {
+        vector<int> values (this->getLength(4));
+        this->getRaw(values.data(), values.size() * 4);
+        return values;
+    }
+private:
+    void getRaw(void* bytes, size_t length) {
+        if (this->pos + length > this->body.size()) throw "SnapshotReader::getRaw(): truncated checkpoint!";
+        memcpy(bytes, this->body.data() + this->pos, length);
+        this->pos += length;
+    }
+    // reads a length prefix and makes sure that many elements are actually left
+    size_t getLength(size_t elementSize) {
+        int32_t length = this->getInt();
+        if (length < 0 || this->pos + (size_t)length * elementSize > this->body.size()) {
+            throw "SnapshotReader::getLength(): truncated checkpoint!";
+        }
+        return length;
+    }
+
+    string body;
+    size_t pos = 0;
+};
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+using namespace std;
+
+/**
+ * A fixed set of worker threads shared by every algorithm
+ * parallelFor() hands out loop indices to the workers and the calling thread, then blocks until they're all done.
+ * With one thread (the default) nothing is spawned and loops run inline, so single-threaded builds
+ * (including WASM without pthreads) go through exactly the same code.
+ * The pool runs one loop at a time: a parallelFor() from another thread while it's busy runs inline on that thread.
+ * An exception thrown by the loop body stops the loop handing out indices and is rethrown to the caller once every thread is done.
+ *
+ * In the browser, the pthreads build must run inside a Worker: blocking the main thread isn't allowed there.
+ **/
+class ThreadPool {
+public:
+    static ThreadPool& getInstance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ~ThreadPool() { this->stopWorkers(); }
+
+    /**
+     * Sets the number of threads that share loop work, counting the caller
+     *
+     * Waits for a parallelFor() running on another thread to finish first
+     *
+     * @preconditions: must not be called from inside a parallelFor()'s body
+     * @param int numThreads
+     * @return void
+     **/
+    void setNumThreads(int numThreads) {
+        lock_guard<mutex> busy(this->loopMtx);
+        if (numThreads < 1) numThreads = 1;
+        if (numThreads == this->getNumThreads()) return;
+        this->stopWorkers();
+        this->stopping = false;
+        for (int i = 1; i < numThreads; i++) {
+            this->workers.push_back(thread(&ThreadPool::work, this));
+        }
+    }
+
+    int getNumThreads() { return this->workers.size() + 1; }
+
+    /**
+     * Runs body(i) for every i in [0, count), spread across the pool
+     * Indices are handed out one at a time, so uneven iterations still balance
+     * A parallelFor() issued from inside another one, or from another thread while the pool is busy, just runs inline
+     *
+     * @param int count
+     * @param const function<void(int)>& body
+     * @return void
+     **/
+    void parallelFor(int count, const function<void(int)>& body) {
+        unique_lock<mutex> busy(this->loopMtx, defer_lock);
+        if (count <= 1 || insideLoop() || !busy.try_lock() || this->workers.empty()) {
+            for (int i = 0; i < count; i++) body(i);
+            return;
+        }
+
+        {
+            unique_lock<mutex> lock(this->mtx);
+            this->body    = &body;
+            this->count   = count;
+            this->next    = 0;
+            this->active  = this->workers.size();
+            this->error   = nullptr;
+            this->generation++;
+        }
+        this->wake.notify_all();
+        this->runIndices();
+
+        exception_ptr error;
+        {
+            unique_lock<mutex> lock(this->mtx);
+            this->done.wait(lock, [this]() { return this->active == 0; });
+            this->body = nullptr;
+            error = this->error;
+            this->error = nullptr;
+        }
+        if (error) rethrow_exception(error);
+    }
+
+private:
+    ThreadPool() {}
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    static bool& insideLoop() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    // keeps the first exception for parallelFor() to rethrow, and hands out no more indices after it
+    void runIndices() {
+        int i;
+        insideLoop() = true;
+        try {
+            while ((i = this->next.fetch_add(1)) < this->count) {
+                (*this->body)(i);
+            }
+        } catch (...) {
+            lock_guard<mutex> lock(this->mtx);
+            if (!this->error) this->error = current_exception();
+            this->next = this->count;
+        }
+        insideLoop() = false;
+    }
+
+    void work() {
+        unsigned long seen = 0;
+        while (true) {
+            {
+                unique_lock<mutex> lock(this->mtx);
+                this->wake.wait(lock, [&]() { return this->stopping || this->generation != seen; });
+                if (this->stopping) return;
+                seen = this->generation;
+            }
+            this->runIndices();
+            {
+                lock_guard<mutex> lock(this->mtx);
+                this->active--;
+            }
+            this->done.notify_one();
+        }
+    }
+
+    void stopWorkers() {
+        {
+            lock_guard<mutex> lock(this->mtx);
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        for (thread& worker : this->workers) worker.join();
+        this->workers.clear();
+    }
+
+    vector<thread> workers;
+    mutex loopMtx;                  // held by the thread whose loop the pool is running
+    mutex mtx;
+    condition_variable wake;
+    condition_variable done;
+    const function<void(int)>* body = nullptr;
+    int  count = 0;
+    atomic<int> next { 0 };
+    int  active = 0;
+    exception_ptr error;            // the first exception the current loop's body threw
+    unsigned long generation = 0;
+    bool stopping = false;
+};
+
+#endif
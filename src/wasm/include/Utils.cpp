@@ -2,8 +2,11 @@
 
 #include <map>
 #include <cmath>
+#include <zlib.h>
+#include <climits>
 #include <regex>
 #include <string>
+#include <cstdint>
 #include <cstring>
 #include <vector>
 #include <fstream>
@@ -29,13 +32,13 @@ vector<string> Utils::split(string str, string delimiter) {
     memcpy( &vec.front(), str.c_str(), str.size() + 1 );
     char* cstr = vec.data();
     char* pch;
-    pch = strtok(cstr,"/");
+    pch = strtok(cstr, delimiter.c_str());
     vector<string> tokens;
     while (pch != NULL)
     {
         string tmp = pch;
         tokens.push_back(tmp);
-        pch = strtok(NULL, "/");
+        pch = strtok(NULL, delimiter.c_str());
     }
     return tokens;
 }
@@ -43,18 +46,26 @@ vector<string> Utils::split(string str, string delimiter) {
 
 /**
  * Returns a ProblemData instance by processing the appropriate file
+ * Cost matrices are stored 16-bit whenever the costs allow it (see ProblemData::compact())
  *
  * @param string filename
  * @return Problemdata data
  **/
 ProblemData Utils::getData(string filename) {
-    if (regex_match(filename, regex(".*/ORLIB/.*"))) {
-        return parseORLIB(filename);
+    ProblemData data;
+    if (regex_match(filename, regex(".*/ORLIB/cap.*"))) {
+        data = parseORLIBLocation(filename);
+    } else if (regex_match(filename, regex(".*/ORLIB/.*"))) {
+        data = parseORLIB(filename);
+    } else if (regex_match(filename, regex(".*/Daskin/.*\\.brd"))) {
+        data = parseBorder(filename);
     } else if (regex_match(filename, regex(".*/Daskin/.*"))) {
-        return parseDaskin(filename);
+        data = parseDaskin(filename);
     } else {
         throw "Unfamiliar data path given!";
     }
+    data.compact();     // every ORLIB p-median and Daskin matrix fits in 16 bits
+    return data;
 }
 
 /**
@@ -66,64 +77,84 @@ ProblemData Utils::getData(string filename) {
  * @return ProblemData data
  **/
 ProblemData Utils::parseORLIB(string filename) {
+    return Utils::parseORLIBNetwork(filename).getData();
+}
+
+/**
+ * Parses an ORLIB warehouse location file (capXX) into a rectangular problem: a few candidate sites, many customers
+ * The file gives "numSites numCustomers", then "capacity fixedCost" per site, then for each customer
+ * its demand followed by the cost of serving all of that demand from each site.
+ * Those costs already include the demand, so every weight stays 1; capacities and fixed costs don't fit the model and are skipped
+ *
+ * @preconditions: assumes file exists, and that it follows the expected format
+ *
+ * @param string filename
+ * @return ProblemData data
+ **/
+ProblemData Utils::parseORLIBLocation(string filename) {
     ifstream infile;
+    int numCandidates, numCustomers;
+    string capacity;
+    double fixedCost, demand, cost;
+
+    infile.open(filename);
+    infile >> numCandidates >> numCustomers;
+    for (int fac = 0; fac < numCandidates; fac++) {
+        infile >> capacity >> fixedCost;    // capacities can be the word "capacity" in the uncapacitated files
+    }
+
     ProblemData data;
-    int numEdges;
+    data.allocate(numCustomers, numCandidates);
+    for (int cust = 0; cust < numCustomers; cust++) {
+        infile >> demand;
+        for (int fac = 0; fac < numCandidates; fac++) {
+            if (!(infile >> cost)) throw "Utils::parseORLIBLocation(): fewer costs than the header says!";
+            data.setCost(cust, fac, (int)round(cost));
+        }
+    }
+    infile.close();
 
-    // get the name of the file
     data.name = Utils::split(filename, "/").back();
+    data.numFacilities = min(5, numCandidates);
+    data.type = { MINIMIZE, SUM, STAR };
+    return data;
+}
+
+/**
+ * Parses a given ORLIB file into a RoadNetwork, which keeps the edge list so the costs can be updated edge by edge later
+ * The costs are the all-pairs shortest paths of the edges (a repeated edge keeps its last weight, as the ORLIB notes say)
+ *
+ * @preconditions: assumes file exists, and that it follows the expected format
+ *
+ * @param string filename
+ * @return RoadNetwork network
+ **/
+RoadNetwork Utils::parseORLIBNetwork(string filename) {
+    ifstream infile;
+    int numNodes, numEdges, numFacilities;
 
     infile.open(filename);
     // read header at top of file: <num_nodes> <num_edges> <num_facilities (p-value, in other words)>
-    infile >> data.numCustomers;
-    infile >> numEdges;
-    infile >> data.numFacilities;
-
-    // build the cost/demand matrices
-    // for now, all demand is 1
-    for (int i = 0; i < data.numCustomers; i++) {
-        vector<int> costs (data.numCustomers, 0);
-        vector<int> demand (data.numCustomers, 1);
-        data.costs.push_back(costs);
-        data.demand.push_back(demand);
-    }
-    for (int i = 0; i < data.numCustomers; i++) {
-        for (int j = 0; j < data.numCustomers; j++) {
-            if (i == j) {
-                data.costs[i][j] = 0;
-            } else {
-                data.costs[i][j] = 10000;
-                data.costs[j][i] = 10000;
-            }
-        }
-    }
+    infile >> numNodes >> numEdges >> numFacilities;
+    RoadNetwork network (numNodes);
 
-    // read in the edges they give us
+    // read in the edges they give us (1-indexed)
     int node1;
     int node2;
     int cost;
-    while (!infile.eof()) {
-        infile >> node1 >> node2 >> cost;
-        data.costs[node1-1][node2-1] = cost;
-        data.costs[node2-1][node1-1] = cost; 
-    }
-
-    // Floyd's Algorithm
-    for (int i = 0; i < data.numCustomers; i++) {
-        for (int j = 0; j < data.numCustomers; j++) {
-            for (int k = 0; k < data.numCustomers; k++) {
-                if (data.costs[i][k] + data.costs[k][j] < data.costs[i][j]) {
-                    data.costs[i][j] = data.costs[i][k] + data.costs[k][j];
-                }
-            }
-        }
+    while (infile >> node1 >> node2 >> cost) {
+        network.addEdge(node1 - 1, node2 - 1, cost);
     }
-
     infile.close();
+    network.computeAllPairs();
 
-    // default values
+    // get the name of the file, plus default values
+    // ORLIB has no demands, so every customer keeps a weight of 1
+    ProblemData& data = network.getDataRef();
+    data.name = Utils::split(filename, "/").back();
+    data.numFacilities = numFacilities;
     data.type = { MINIMIZE, MAX, STAR };
-    return data;
+    return network;
 }
 
 /**
@@ -132,62 +163,95 @@ ProblemData Utils::parseORLIB(string filename) {
  * @preconditions: assumes file exists, and that it follows the expected format
  *
  * @param string filename
+ * @param Metric metric: how the coordinates become costs (see CoordinateCosts.h)
  * @return ProblemData data
  **/
-ProblemData Utils::parseDaskin(string filename) {
+ProblemData Utils::parseDaskin(string filename, Metric metric) {
     ifstream infile;
-    ProblemData data;
-
-    // get the name of the file
-    data.name = Utils::split(filename, "/").back();
 
     string tmp;
     float lng, lat;
+    double demand;
     vector<vector<float>> nodeList;
+    vector<int> weights;
     vector<float> coords;
-    data.numCustomers = 0;
     // a line in this file contains these white-space separated fields (in order):
         // nodeNumber, lng, lat, demand1, demand2, fixedCost, cityName
-    // for now, we only want lng and lat
+    // we want lng, lat and demand1 (the population)
     infile.open(filename);
     while (!infile.eof()) {
         infile >> tmp;
         if (tmp == "") break;
 
-        data.numCustomers++;
-        infile >> lng >> lat;
+        infile >> lng >> lat >> demand;
         coords.push_back(lng);
         coords.push_back(lat);
         nodeList.push_back(coords);
         coords.clear();
+        weights.push_back(max(1, (int)round(demand / DEMAND_UNIT)));
         // ignore the rest of the input
         getline(infile, tmp);
         tmp = "";
     }
 
-    // build the cost/demand matrices
-    // for now, all demand is 1
-    for (int i = 0; i < data.numCustomers; i++) {
-        vector<int> costs (data.numCustomers, 0);
-        vector<int> demand (data.numCustomers, 1);
-        data.costs.push_back(costs);
-        data.demand.push_back(demand);
-    }
+    infile.close();
 
-    int cost;
-    for (int i = 0; i < data.numCustomers; i++) {
-        for (int j = 0; j < data.numCustomers; j++) {
-            if (i == j) {
-                data.costs[i][j] = 0;
-            } else {
-                cost = Utils::calcCost(nodeList[i], nodeList[j]);
-                data.costs[i][j] = cost;
-                data.costs[j][i] = cost;
-            }
-        }
-    }
+    // get the name of the file
+    ProblemData data = Utils::fromCoordinates(nodeList, metric);
+    data.name = Utils::split(filename, "/").back();
+    copy(weights.begin(), weights.end(), data.demand->begin());
+    return data;
+}
 
+/**
+ * Parses a given border point file (.brd): the number of points on the first line, then one "lng lat" pair per line
+ *
+ * @preconditions: assumes file exists, and that it follows the expected format
+ *
+ * @param string filename
+ * @param Metric metric: how the coordinates become costs (see CoordinateCosts.h)
+ * @return ProblemData data
+ **/
+ProblemData Utils::parseBorder(string filename, Metric metric) {
+    ifstream infile;
+    int numPoints;
+    float lng, lat;
+    vector<vector<float>> nodeList;
+
+    infile.open(filename);
+    infile >> numPoints;
+    while ((int) nodeList.size() < numPoints && infile >> lng >> lat) {
+        nodeList.push_back({ lng, lat });
+    }
     infile.close();
+    if ((int) nodeList.size() != numPoints) throw "Utils::parseBorder(): fewer points than the header says!";
+
+    ProblemData data = Utils::fromCoordinates(nodeList, metric);
+    data.name = Utils::split(filename, "/").back();
+    return data;
+}
+
+/**
+ * Builds a problem over the given <lng, lat> points
+ * Up to DENSE_COST_LIMIT points get a cost matrix, built by CoordinateCosts::fillMatrix(); every demand starts at 1.
+ * past that the costs stay implicit, since the matrix would be hundreds of MB (see CoordinateCosts.h)
+ *
+ * @param const vector<vector<float>>& nodeList
+ * @param Metric metric
+ * @return ProblemData data
+ **/
+ProblemData Utils::fromCoordinates(const vector<vector<float>>& nodeList, Metric metric) {
+    ProblemData data;
+    int n = nodeList.size();
+    data.allocateCoordinates(n);
+    for (int i = 0; i < n; i++) {
+        data.coordinates->x[i] = nodeList[i][0];
+        data.coordinates->y[i] = nodeList[i][1];
+    }
+    data.setMetric(metric);
+    if (n <= DENSE_COST_LIMIT) {
+        data.materialize();
+    }
 
     // default values
     data.type = { MINIMIZE, MAX, STAR };
@@ -197,7 +261,7 @@ ProblemData Utils::parseDaskin(string filename) {
 
 
 /**
- * Calculates the distance between two sets of coordinates for use in Utils::parseDaskin()
+ * Calculates the distance between two sets of coordinates (the PLANAR metric; CoordinateCosts computes the same thing in bulk)
  * Scales that distance up and truncates it so we get an integer number
  * Doesn't respect the actual calculation of lng/lat distances;
  * just uses the simple distance calculation from basic algebra
@@ -210,6 +274,227 @@ int Utils::calcCost(const vector<float>& coords1, const vector<float>& coords2)
     return (int)(100 * sqrt(pow(coords1[0] - coords2[0], 2.0) + pow(coords1[1] - coords2[1], 2.0)));
 }
 
+/**
+ * Binary instance format (little-endian), as written by encodeInstance() and read by decodeInstance()
+ *     "CDFI", u32 version, u32 numCustomers, u32 numFacilities,
+ *     u8 objective, u8 aggregate, u8 measure, u8 flags, u32 nameLength, name, [u32 numCandidates,]
+ *     u32 rawLength, u32 compressedLength, zlib-deflated costs
+ * numCandidates is only there with INSTANCE_RECT (otherwise every customer is a candidate).
+ * The costs are facility-major; with INSTANCE_UPPER (square problems only) just the entries with cust >= fac are stored,
+ * and with INSTANCE_16BIT each cost takes two bytes instead of four.
+ * With INSTANCE_COORDS (implicit problems) the payload is every node's float x, then every node's float y, instead of costs;
+ * INSTANCE_HAVERSINE marks those coordinates as lng/lat for the HAVERSINE metric.
+ * With INSTANCE_DEMAND (any customer's demand isn't 1) every customer's i32 demand follows, in planes of its own.
+ * The bytes are split into planes (every value's low byte, then every value's next byte, ...), which deflates much better
+ **/
+const uint32_t INSTANCE_VERSION = 1;
+const uint8_t  INSTANCE_16BIT  = 1;
+const uint8_t  INSTANCE_UPPER  = 2;
+const uint8_t  INSTANCE_COORDS = 4;
+const uint8_t  INSTANCE_HAVERSINE = 8;
+const uint8_t  INSTANCE_DEMAND = 16;
+const uint8_t  INSTANCE_RECT = 32;
+
+static void putUint32(string& out, uint32_t value) {
+    char bytes[4];
+    memcpy(bytes, &value, 4);
+    out.append(bytes, 4);
+}
+
+static uint32_t getUint32(const string& in, size_t& pos) {
+    if (pos + 4 > in.size()) throw "Utils::decodeInstance(): truncated instance!";
+    uint32_t value;
+    memcpy(&value, in.data() + pos, 4);
+    pos += 4;
+    return value;
+}
+
+/**
+ * Serializes a problem, with its finished cost matrix, into the compact binary instance format
+ * Uses 16-bit costs and/or the upper triangle whenever that loses nothing; implicit problems just store their coordinates
+ *
+ * @param const ProblemData& data
+ * @return string bytes
+ **/
+string Utils::encodeInstance(const ProblemData& data) {
+    int n = data.numCustomers;
+    uint8_t flags;
+    vector<int32_t> values;
+    if (data.isImplicit()) {
+        flags = INSTANCE_COORDS | (data.coordinates->metric == HAVERSINE ? INSTANCE_HAVERSINE : 0);
+        values.resize(2 * n);
+        memcpy(values.data(), data.coordinates->x.data(), n * 4);
+        memcpy(values.data() + n, data.coordinates->y.data(), n * 4);
+    } else {
+        bool symmetric = data.isSquare();
+        int  minCost = 0, maxCost = 0;
+        for (int fac = 0; fac < data.numCandidates; fac++) {
+            for (int cust = 0; cust < n; cust++) {
+                int cost = data.getCost(cust, fac);
+                minCost = min(minCost, cost);
+                maxCost = max(maxCost, cost);
+                symmetric = symmetric && cost == data.getCost(fac, cust);
+            }
+        }
+        flags = (symmetric ? INSTANCE_UPPER : 0) | (minCost >= INT16_MIN && maxCost <= INT16_MAX ? INSTANCE_16BIT : 0) |
+                (data.isSquare() ? 0 : INSTANCE_RECT);
+
+        for (int fac = 0; fac < data.numCandidates; fac++) {
+            for (int cust = (symmetric ? fac : 0); cust < n; cust++) {
+                values.push_back(data.getCost(cust, fac));
+            }
+        }
+    }
+    const vector<int>& demand = *data.demand;
+    if (any_of(demand.begin(), demand.end(), [](int weight) { return weight != 1; })) {
+        flags |= INSTANCE_DEMAND;
+    }
+
+    size_t count = values.size();
+    int width = (flags & INSTANCE_16BIT ? 2 : 4);
+    string raw (count * width + (flags & INSTANCE_DEMAND ? n * 4 : 0), '\0');
+    for (size_t i = 0; i < count; i++) {
+        for (int plane = 0; plane < width; plane++) {
+            raw[plane * count + i] = (char)((uint32_t)values[i] >> (8 * plane));
+        }
+    }
+    if (flags & INSTANCE_DEMAND) {
+        char* weights = &raw[count * width];
+        for (int cust = 0; cust < n; cust++) {
+            for (int plane = 0; plane < 4; plane++) {
+                weights[plane * n + cust] = (char)((uint32_t)demand[cust] >> (8 * plane));
+            }
+        }
+    }
+
+    uLongf compressedLength = compressBound(raw.size());
+    string compressed (compressedLength, '\0');
+    if (compress2((Bytef*)&compressed[0], &compressedLength, (const Bytef*)raw.data(), raw.size(), 9) != Z_OK) {
+        throw "Utils::encodeInstance(): compression failed!";
+    }
+    compressed.resize(compressedLength);
+
+    string out = "CDFI";
+    putUint32(out, INSTANCE_VERSION);
+    putUint32(out, n);
+    putUint32(out, data.numFacilities);
+    out += (char)data.type.objective;
+    out += (char)data.type.aggregate;
+    out += (char)data.type.measure;
+    out += (char)flags;
+    putUint32(out, data.name.size());
+    out += data.name;
+    if (flags & INSTANCE_RECT) {
+        putUint32(out, data.numCandidates);
+    }
+    putUint32(out, raw.size());
+    putUint32(out, compressed.size());
+    out += compressed;
+    return out;
+}
+
+/**
+ * Rebuilds a problem from the binary instance format
+ * The cost matrix comes back exactly as it was encoded, so no shortest paths or distances are recomputed
+ *
+ * @param const string& bytes
+ * @return ProblemData data
+ **/
+ProblemData Utils::decodeInstance(const string& bytes) {
+    size_t pos = 4;
+    if (bytes.compare(0, 4, "CDFI") != 0) throw "Utils::decodeInstance(): not an instance!";
+    if (getUint32(bytes, pos) != INSTANCE_VERSION) throw "Utils::decodeInstance(): unsupported instance version!";
+
+    ProblemData data;
+    uint32_t numCustomers  = getUint32(bytes, pos);
+    uint32_t numFacilities = getUint32(bytes, pos);
+    if (pos + 4 > bytes.size()) throw "Utils::decodeInstance(): truncated instance!";
+    uint8_t objective = bytes[pos], aggregate = bytes[pos+1], measure = bytes[pos+2];
+    uint8_t flags = bytes[pos+3];
+    pos += 4;
+    if (objective > MINIMIZE || aggregate > SUM || measure > RAY) throw "Utils::decodeInstance(): corrupt instance!";
+    data.type = { (Objective)objective, (Aggregate)aggregate, (Measure)measure };
+    uint32_t nameLength = getUint32(bytes, pos);
+    if (nameLength > bytes.size() - pos) throw "Utils::decodeInstance(): truncated instance!";
+    data.name = bytes.substr(pos, nameLength);
+    pos += nameLength;
+    uint32_t numCandidates = (flags & INSTANCE_RECT ? getUint32(bytes, pos) : numCustomers);
+    uLongf rawLength = getUint32(bytes, pos);
+    uint32_t compressedLength = getUint32(bytes, pos);
+    if (compressedLength > bytes.size() - pos) throw "Utils::decodeInstance(): truncated instance!";
+
+    // everything below indexes with ints, and the payload's size follows from the header, so check both before allocating it
+    bool coords = flags & INSTANCE_COORDS;
+    bool symmetric = flags & INSTANCE_UPPER;
+    int width = (flags & INSTANCE_16BIT ? 2 : 4);
+    if ((symmetric && (flags & INSTANCE_RECT)) || (coords && (flags & (INSTANCE_RECT | INSTANCE_UPPER | INSTANCE_16BIT)))) {
+        throw "Utils::decodeInstance(): corrupt instance!";
+    }
+    if (numCustomers == 0 || numCustomers > INT_MAX / 2 || numCandidates == 0 || numCandidates > numCustomers || numFacilities > numCandidates) {
+        throw "Utils::decodeInstance(): corrupt instance!";
+    }
+    int n = numCustomers, m = numCandidates;
+    uint64_t count = (coords ? (uint64_t)2 * n : (symmetric ? (uint64_t)n * (n + 1) / 2 : (uint64_t)m * n));
+    uint64_t expected = count * width + (flags & INSTANCE_DEMAND ? (uint64_t)n * 4 : 0);
+    if ((!coords && (uint64_t)m * n > INT_MAX) || expected != (size_t)expected || rawLength != expected) {
+        throw "Utils::decodeInstance(): corrupt instance!";
+    }
+    if (expected > (uint64_t)compressedLength * 1032 + 64) {    // more than deflate can compress into that many bytes
+        throw "Utils::decodeInstance(): corrupt instance!";
+    }
+    data.numFacilities = numFacilities;
+
+    string raw (rawLength, '\0');
+    if (uncompress((Bytef*)&raw[0], &rawLength, (const Bytef*)bytes.data() + pos, compressedLength) != Z_OK || rawLength != expected) {
+        throw "Utils::decodeInstance(): corrupt instance!";
+    }
+
+    const uint8_t* planes = (const uint8_t*)raw.data();
+    auto readDemand = [&]() {
+        if (!(flags & INSTANCE_DEMAND)) return;
+        const uint8_t* weights = planes + count * width;
+        for (int cust = 0; cust < n; cust++) {
+            uint32_t bits = 0;
+            for (int plane = 0; plane < 4; plane++) {
+                bits |= (uint32_t)weights[plane * n + cust] << (8 * plane);
+            }
+            (*data.demand)[cust] = (int32_t)bits;
+        }
+    };
+    if (coords) {
+        data.allocateCoordinates(n);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t bits = 0;
+            for (int plane = 0; plane < 4; plane++) {
+                bits |= (uint32_t)planes[plane * count + i] << (8 * plane);
+            }
+            memcpy(i < (size_t) n ? &data.coordinates->x[i] : &data.coordinates->y[i - n], &bits, 4);
+        }
+        data.setMetric(flags & INSTANCE_HAVERSINE ? HAVERSINE : PLANAR);
+        readDemand();
+        return data;
+    }
+
+    data.allocate(n, m);
+    if (width == 2) data.compact();     // 16-bit costs go straight into 16-bit storage
+    size_t i = 0;
+    for (int fac = 0; fac < m; fac++) {
+        for (int cust = (symmetric ? fac : 0); cust < n; cust++, i++) {
+            uint32_t bits = 0;
+            for (int plane = 0; plane < width; plane++) {
+                bits |= (uint32_t)planes[plane * count + i] << (8 * plane);
+            }
+            int cost = (width == 2 ? (int16_t)bits : (int32_t)bits);
+            data.setCost(cust, fac, cost);
+            if (symmetric) {
+                data.setCost(fac, cust, cost);
+            }
+        }
+    }
+    readDemand();
+    return data;
+}
+
 /**
  * Prints a white-space separated matrix
  * Prints based on the given size of the matrix, so it may overrun the terminal
@@ -220,8 +505,8 @@ int Utils::calcCost(const vector<float>& coords1, const vector<float>& coords2)
  * @return void
  **/
 void Utils::printMatrix(const vector<vector<int>>& matrix) {
-    for (int i = 0; i < matrix.size(); i++) {
-        for (int j = 0; j < matrix[i].size(); j++) {
+    for (int i = 0; i < (int) matrix.size(); i++) {
+        for (int j = 0; j < (int) matrix[i].size(); j++) {
             cout << matrix[i][j] << " ";
         }
         cout << endl;
@@ -237,7 +522,7 @@ void Utils::printMatrix(const vector<vector<int>>& matrix) {
  * @return void
  **/
 void Utils::printVector(const vector<int>& vect) {
-    for (int i = 1; i <= vect.size(); i++) {
+    for (int i = 1; i <= (int) vect.size(); i++) {
         cout << setw(3) << vect[i-1];
         if (i % 10 == 0) {
             cout << endl;
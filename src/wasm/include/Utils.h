@@ -6,15 +6,28 @@
 #include <string>
 #include "Algorithm.h"
 #include "ProblemData.h"
+#include "RoadNetwork.h"
 #include "ProblemResults.h"
 using namespace std;
 
+// coordinate problems with more nodes than this keep implicit costs instead of building a cost matrix
+const int DENSE_COST_LIMIT = 2000;
+
+// Daskin demands are head counts; weights count thousands of people (at least 1) so weighted STAR objectives fit in an int
+const double DEMAND_UNIT = 1000.0;
+
 namespace Utils {
     vector<string> split(string, string);
 	ProblemData getData(string);
 	ProblemData parseORLIB(string);
-	ProblemData parseDaskin(string);
+	ProblemData parseORLIBLocation(string);
+	RoadNetwork parseORLIBNetwork(string);
+	ProblemData parseDaskin(string, Metric = PLANAR);
+	ProblemData parseBorder(string, Metric = PLANAR);
+	ProblemData fromCoordinates(const vector<vector<float>>&, Metric = PLANAR);
     int calcCost(const vector<float>&, const vector<float>&);
+    string encodeInstance(const ProblemData&);
+    ProblemData decodeInstance(const string&);
 	void printMatrix(const vector<vector<int>>&);
     void printVector(const vector<int>&);
     void optimizeForEachProblemType(Algorithm*, ProblemData);
@@ -0,0 +1,267 @@
+#include "VNS.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+using namespace std;
+
+/**
+ * Default constructor
+ * Uses VNS_MAX_ITERS shakes of up to VNS_K_MAX facilities
+ **/
+VNS::VNS() : VNS(VNS_K_MAX) {}
+
+/**
+ * Constructor for setting the largest shake
+ *
+ * @param int kMax: the most facilities a shake swaps
+ **/
+VNS::VNS(int kMax) {
+    this->kMax = kMax;
+    this->maxIterations = VNS_MAX_ITERS;
+    this->k = 1;
+    this->incumbentObjective = 0;
+    this->fast = false;
+}
+
+string VNS::getJSONParameters() {
+    string json = "{";
+    json += "maxIterations: "       + to_string(this->maxIterations);
+    json += ", kMax: "              + to_string(this->kMax);
+    json += ", fastInterchange: "   + string(FastInterchange::supports(this->data) ? "true" : "false");
+    json += "}";
+    return json;
+}
+
+/**
+ * Builds a starting solution (see Initializers::construct()) and descends to its local optimum
+ **/
+void VNS::setup() {
+    this->setupFrom(Initializers::construct(AUTO_INIT, this->data, this->rng));
+}
+
+/**
+ * Same as setup(), but from the given solution
+ *
+ * @param const vector<int>& facilities
+ **/
+void VNS::setupFrom(const vector<int>& facilities) {
+    this->fast = FastInterchange::supports(this->data);
+    this->k = 1;
+    this->reset(facilities);
+    this->localSearch();
+    this->incumbent = this->getFacilities();
+    this->incumbentObjective = this->getObjective();
+}
+
+/**
+ * One shake and descent
+ * The search only moves to the local optimum if it beats the incumbent; otherwise it starts over from the incumbent
+ *
+ * @preconditions: assumes setup() has run
+ * @postconditions: promises to keep incumbent the best solution found so far
+ **/
+void VNS::iterate() {
+    int size = min(this->k, min((int) this->incumbent.size(), this->data.numCandidates - (int) this->incumbent.size()));
+    if (size <= 0) return;      // every candidate is open: there's nothing to swap
+
+    this->shake(size);
+    this->localSearch();
+    if (this->comparator(this->getObjective(), this->incumbentObjective)) {
+        this->incumbent = this->getFacilities();
+        this->incumbentObjective = this->getObjective();
+        this->k = 1;
+        if (this->listener != nullptr) {
+            this->listener->handleResults(this->best());
+        }
+    } else {
+        this->k = (this->k >= this->kMax ? 1 : this->k + 1);
+        this->reset(this->incumbent);
+    }
+}
+
+/**
+ * Returns the best solution found so far
+ *
+ * @return ProblemResults
+ **/
+ProblemResults VNS::best() {
+    ProblemResults results {
+                               this->elapsed,
+                               this->incumbentObjective,
+                               this->incumbent,
+                               this->data.assignCustomers(this->incumbent),
+                               this->data.type,
+                           };
+    return results;
+}
+
+/**
+ * Writes the shake size and the incumbent; the search structures are rebuilt from it on load
+ *
+ * @param SnapshotWriter& out
+ * @return void
+ **/
+void VNS::saveState(SnapshotWriter& out) {
+    out.putInt(this->kMax);
+    out.putInt(this->k);
+    out.putVector(this->incumbent);
+    out.putInt(this->incumbentObjective);
+}
+
+void VNS::loadState(SnapshotReader& in) {
+    this->kMax = in.getInt();
+    this->k    = in.getInt();
+    this->incumbent          = in.getVector();
+    this->incumbentObjective = in.getInt();
+    this->fast = FastInterchange::supports(this->data);
+    this->reset(this->incumbent);
+}
+
+// starts the search structures over from the given facilities
+void VNS::reset(const vector<int>& facilities) {
+    if (this->fast) {
+        this->interchange.reset(this->data, facilities);
+    } else {
+        this->state.reset(this->data, facilities);
+    }
+    if (this->open.size() != this->data.numCandidates) {
+        this->open.reset(this->data.numCandidates);
+    }
+    this->open.assign(facilities);
+}
+
+/**
+ * Swaps size distinct facilities, picked at random, for random closed candidates
+ * The open set is rebuilt first, so its draws only depend on the facilities and not on the swaps that led to them
+ *
+ * @param int size
+ * @return void
+ **/
+void VNS::shake(int size) {
+    int p = this->getFacilities().size();
+    this->open.assign(this->getFacilities());
+    vector<int> slots (p);
+    for (int slot = 0; slot < p; slot++) {
+        slots[slot] = slot;
+    }
+    for (int i = 0; i < size; i++) {
+        std::swap(slots[i], slots[i + this->rng.nextInt(p - i)]);
+        this->swap(slots[i], this->open.randomClosed(this->rng));
+    }
+}
+
+// opens fac in place of the facility in the given slot
+void VNS::swap(int slot, int fac) {
+    this->open.swap(this->getFacilities()[slot], fac);
+    if (this->fast) {
+        this->interchange.swap(this->data, slot, fac);
+    } else {
+        this->state.replace(this->data, slot, fac);
+    }
+}
+
+// swap local search until a whole pass over the candidates improves nothing, or the search runs out of time
+// (see Algorithm::isOutOfTime(): a pass can take seconds on a large problem, so it's checked every VNS_CLOCK_INTERVAL candidates too)
+void VNS::localSearch() {
+    while (!this->isOutOfTime() && (this->fast ? this->fastPass() : this->genericPass()));
+}
+
+/**
+ * One pass of fast interchange: every closed candidate, from a random one on, goes in wherever it helps most, if anywhere
+ *
+ * @return bool whether anything improved
+ **/
+bool VNS::fastPass() {
+    int numCandidates = this->data.numCandidates;
+    int start = this->rng.nextInt(numCandidates);
+    bool improved = false;
+    for (int i = 0; i < numCandidates; i++) {
+        int fac = (start + i < numCandidates ? start + i : start + i - numCandidates);
+        if (this->open.isOpen(fac)) continue;
+        if (i % VNS_CLOCK_INTERVAL == 0 && this->isOutOfTime()) break;
+        int slot;
+        if (this->interchange.bestSwap(this->data, fac, slot) > 0) {
+            this->swap(slot, fac);
+            improved = true;
+        }
+    }
+    return improved;
+}
+
+/**
+ * One pass of plain swap local search: every closed candidate, from a random one on, goes in the first slot where it helps, if any
+ * Each swap is tried and undone on the IncrementalObjective, so it costs two O(n) moves
+ * When minimizing the largest star or radius, only a candidate nearer to (or as near as) one of the worst facility's customers
+ * can help anywhere but in the worst facility's slot: everywhere else, the worst facility keeps its customers and can only gain more
+ *
+ * @return bool whether anything improved
+ **/
+bool VNS::genericPass() {
+    int numCandidates = this->data.numCandidates;
+    int p = this->getFacilities().size();
+    bool prune = (this->data.type.objective == MINIMIZE && this->data.type.aggregate == MAX && this->data.type.measure != RAY);
+
+    // the worst facility's customers and what they pay it
+    int worst = -1;
+    vector<int> customers, costs, assignments;
+    auto findWorst = [&]() {
+        worst = this->worstSlot();
+        int worstFac = this->getFacilities()[worst];
+        this->state.getAssignments(assignments);
+        customers.clear();
+        costs.clear();
+        for (int cust = 0; cust < this->data.numCustomers; cust++) {
+            if (assignments[cust] != worstFac) continue;
+            customers.push_back(cust);
+            costs.push_back(this->data.getCost(cust, worstFac));
+        }
+    };
+    if (prune) findWorst();
+
+    int start = this->rng.nextInt(numCandidates);
+    int objective = this->getObjective();
+    bool improved = false;
+    for (int i = 0; i < numCandidates; i++) {
+        int fac = (start + i < numCandidates ? start + i : start + i - numCandidates);
+        if (this->open.isOpen(fac)) continue;
+        if (i % VNS_CLOCK_INTERVAL == 0 && this->isOutOfTime()) break;
+
+        bool steals = !prune;
+        for (int c = 0; c < (int) customers.size() && !steals; c++) {
+            steals = (this->data.getCost(customers[c], fac) <= costs[c]);
+        }
+        for (int slot = 0; slot < p; slot++) {
+            if (!steals && slot != worst) continue;
+            int old = this->getFacilities()[slot];
+            this->state.replace(this->data, slot, fac);
+            if (this->comparator(this->state.getObjective(), objective)) {
+                this->open.swap(old, fac);
+                objective = this->state.getObjective();
+                improved = true;
+                if (prune) findWorst();
+                break;
+            }
+            this->state.replace(this->data, slot, old);
+        }
+    }
+    return improved;
+}
+
+// the slot of the facility with the largest measure
+int VNS::worstSlot() {
+    vector<pair<int, int>> measures = this->state.getMeasures();
+    auto worst = max_element(measures.begin(), measures.end(), [](const pair<int, int>& a, const pair<int, int>& b) {
+        return a.second < b.second;
+    });
+    const vector<int>& facilities = this->getFacilities();
+    return find(facilities.begin(), facilities.end(), worst->first) - facilities.begin();
+}
+
+const vector<int>& VNS::getFacilities() {
+    return (this->fast ? this->interchange.getFacilities() : this->state.getFacilities());
+}
+
+int VNS::getObjective() {
+    return (this->fast ? this->interchange.getObjective() : this->state.getObjective());
+}
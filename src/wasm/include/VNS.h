@@ -0,0 +1,75 @@
+#ifndef VNS_H
+#define VNS_H
+
+#include <vector>
+#include <string>
+#include "Algorithm.h"
+#include "FacilitySet.h"
+#include "Initializers.h"
+#include "FastInterchange.h"
+#include "IncrementalObjective.h"
+using namespace std;
+
+// default values for parameters
+const int VNS_MAX_ITERS      = 1000;    // shakes
+const int VNS_K_MAX          = 5;       // the largest shake, in facilities swapped at random
+const int VNS_CLOCK_INTERVAL = 16;      // candidates a local search pass tries between looks at the clock
+
+
+
+/**
+ * Basic Variable Neighborhood Search: every iteration shakes the incumbent by swapping k of its facilities for random closed ones,
+ * descends to a local optimum with swap local search, and moves there only if it's better.
+ * k goes back to 1 after every improvement and grows by one (up to kMax, then wraps) after every failure.
+ *
+ * The local search takes the first improving swap for each candidate in turn, from a random starting candidate,
+ * until a whole pass over the candidates finds none:
+ *     + for the sum of stars (the p-median objective) it scores each candidate against every slot at once
+ *       with fast interchange (see FastInterchange)
+ *     + otherwise it tries the swaps one by one on an IncrementalObjective; when minimizing the largest star or radius,
+ *       a candidate that takes none of the worst facility's customers can only help by replacing the worst facility,
+ *       so that's the only swap tried for it
+ **/
+class VNS : public Algorithm {
+public:
+    VNS();
+    VNS(int);       // kMax
+    ~VNS() {};
+    string getName() override { return "VNS"; }
+    string getJSONParameters() override;
+    ProblemResults best() override;
+
+    void setKMax(int val) { this->kMax = val; }
+    int  getKMax() { return this->kMax; }
+protected:
+    void setup() override;
+    void setupFrom(const vector<int>&) override;
+    void iterate() override;
+    void saveState(SnapshotWriter&) override;
+    void loadState(SnapshotReader&) override;
+private:
+    /* functions */
+    void reset(const vector<int>&);
+    void shake(int);
+    void swap(int, int);
+    void localSearch();
+    bool fastPass();
+    bool genericPass();
+    int  worstSlot();
+    const vector<int>& getFacilities();
+    int  getObjective();
+
+    /* parameters */
+    int kMax;
+
+    /* working data */
+    int k;                          // size of the next shake
+    vector<int> incumbent;          // the best solution so far; every shake starts from it
+    int incumbentObjective;
+    bool fast;                      // whether the gain tables apply to this problem (see FastInterchange::supports())
+    FastInterchange interchange;    // the solution being searched, when fast
+    IncrementalObjective state;     // the solution being searched, otherwise
+    FacilitySet open;               // which facilities the solution being searched has open
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef VECOPS_H
+#define VECOPS_H
+
+/**
+ * Thin abstraction over the int32 vector instructions the evaluation kernels need
+ * One source compiles to WASM SIMD128 (-msimd128), AVX2 (-mavx2), SSE2 (any x86-64) or plain scalar code,
+ * picked by the compiler's own feature macros. Kernels are written against VecOps::Int and never
+ * touch the intrinsics directly. load() also takes 16-bit values, sign-extending them into the 32-bit lanes.
+ *
+ * VecOps::Real is the double-precision counterpart (REAL_WIDTH lanes) used to build distance matrices.
+ * Its operations are plain IEEE ones, so every lane gets exactly the value the scalar expression would.
+ * The names carry a "Real" suffix because on SIMD128 both types are the same v128_t.
+ **/
+#if defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+#elif defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+#include <cmath>
+#include <cstdint>
+
+namespace VecOps {
+
+#if defined(__wasm_simd128__)
+
+    const char* const NAME = "simd128";
+    const int WIDTH = 4;
+    typedef v128_t Int;
+
+    inline Int  load(const int* p)        { return wasm_v128_load(p); }
+    inline Int  load(const int16_t* p)    { return wasm_i32x4_load16x4(p); }
+    inline void store(int* p, Int v)      { wasm_v128_store(p, v); }
+    inline Int  splat(int x)              { return wasm_i32x4_splat(x); }
+    inline Int  lessThan(Int a, Int b)    { return wasm_i32x4_lt(a, b); }
+    inline Int  select(Int m, Int a, Int b) { return wasm_v128_bitselect(a, b, m); }  // m ? a : b, lane by lane
+    inline Int  min(Int a, Int b)         { return wasm_i32x4_min(a, b); }
+    inline Int  max(Int a, Int b)         { return wasm_i32x4_max(a, b); }
+    inline Int  add(Int a, Int b)         { return wasm_i32x4_add(a, b); }
+    inline Int  mul(Int a, Int b)         { return wasm_i32x4_mul(a, b); }
+
+    const int REAL_WIDTH = 2;
+    typedef v128_t Real;
+
+    inline Real loadReal(const double* p)         { return wasm_v128_load(p); }
+    inline void storeReal(double* p, Real v)      { wasm_v128_store(p, v); }
+    inline Real splatReal(double x)               { return wasm_f64x2_splat(x); }
+    inline Real subReal(Real a, Real b)           { return wasm_f64x2_sub(a, b); }
+    inline Real addReal(Real a, Real b)           { return wasm_f64x2_add(a, b); }
+    inline Real mulReal(Real a, Real b)           { return wasm_f64x2_mul(a, b); }
+    inline Real sqrtReal(Real a)                  { return wasm_f64x2_sqrt(a); }
+    inline Real widenDiff(const float* p, float x) {
+        return wasm_f64x2_promote_low_f32x4(wasm_f32x4_sub(wasm_v128_load64_zero(p), wasm_f32x4_splat(x)));
+    }
+    inline void storeTruncated(int* p, Real v)    { wasm_v128_store64_lane(p, wasm_i32x4_trunc_sat_f64x2_zero(v), 0); }
+
+#elif defined(__AVX2__)
+
+    const char* const NAME = "avx2";
+    const int WIDTH = 8;
+    typedef __m256i Int;
+
+    inline Int  load(const int* p)        { return _mm256_loadu_si256((const __m256i*)p); }
+    inline Int  load(const int16_t* p)    { return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p)); }
+    inline void store(int* p, Int v)      { _mm256_storeu_si256((__m256i*)p, v); }
+    inline Int  splat(int x)              { return _mm256_set1_epi32(x); }
+    inline Int  lessThan(Int a, Int b)    { return _mm256_cmpgt_epi32(b, a); }
+    inline Int  select(Int m, Int a, Int b) { return _mm256_blendv_epi8(b, a, m); }
+    inline Int  min(Int a, Int b)         { return _mm256_min_epi32(a, b); }
+    inline Int  max(Int a, Int b)         { return _mm256_max_epi32(a, b); }
+    inline Int  add(Int a, Int b)         { return _mm256_add_epi32(a, b); }
+    inline Int  mul(Int a, Int b)         { return _mm256_mullo_epi32(a, b); }
+
+    const int REAL_WIDTH = 4;
+    typedef __m256d Real;
+
+    inline Real loadReal(const double* p)         { return _mm256_loadu_pd(p); }
+    inline void storeReal(double* p, Real v)      { _mm256_storeu_pd(p, v); }
+    inline Real splatReal(double x)               { return _mm256_set1_pd(x); }
+    inline Real subReal(Real a, Real b)           { return _mm256_sub_pd(a, b); }
+    inline Real addReal(Real a, Real b)           { return _mm256_add_pd(a, b); }
+    inline Real mulReal(Real a, Real b)           { return _mm256_mul_pd(a, b); }
+    inline Real sqrtReal(Real a)                  { return _mm256_sqrt_pd(a); }
+    inline Real widenDiff(const float* p, float x) { return _mm256_cvtps_pd(_mm_sub_ps(_mm_loadu_ps(p), _mm_set1_ps(x))); }
+    inline void storeTruncated(int* p, Real v)    { _mm_storeu_si128((__m128i*)p, _mm256_cvttpd_epi32(v)); }
+
+#elif defined(__SSE2__)
+
+    const char* const NAME = "sse2";
+    const int WIDTH = 4;
+    typedef __m128i Int;
+
+    inline Int  load(const int* p)        { return _mm_loadu_si128((const __m128i*)p); }
+    inline Int  load(const int16_t* p)    { __m128i v = _mm_loadl_epi64((const __m128i*)p); return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); }
+    inline void store(int* p, Int v)      { _mm_storeu_si128((__m128i*)p, v); }
+    inline Int  splat(int x)              { return _mm_set1_epi32(x); }
+    inline Int  lessThan(Int a, Int b)    { return _mm_cmplt_epi32(a, b); }
+    inline Int  select(Int m, Int a, Int b) { return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b)); }
+    inline Int  min(Int a, Int b)         { return select(lessThan(a, b), a, b); }    // SSE2 has no 32-bit min/max
+    inline Int  max(Int a, Int b)         { return select(lessThan(a, b), b, a); }
+    inline Int  add(Int a, Int b)         { return _mm_add_epi32(a, b); }
+    inline Int  mul(Int a, Int b) {       // SSE2 only multiplies lanes 0 and 2, so do the odd lanes separately and interleave
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+
+    const int REAL_WIDTH = 2;
+    typedef __m128d Real;
+
+    inline Real loadReal(const double* p)         { return _mm_loadu_pd(p); }
+    inline void storeReal(double* p, Real v)      { _mm_storeu_pd(p, v); }
+    inline Real splatReal(double x)               { return _mm_set1_pd(x); }
+    inline Real subReal(Real a, Real b)           { return _mm_sub_pd(a, b); }
+    inline Real addReal(Real a, Real b)           { return _mm_add_pd(a, b); }
+    inline Real mulReal(Real a, Real b)           { return _mm_mul_pd(a, b); }
+    inline Real sqrtReal(Real a)                  { return _mm_sqrt_pd(a); }
+    // (double)(p[i] - x): the subtraction happens in float, as it would in scalar code
+    inline Real widenDiff(const float* p, float x) {
+        return _mm_cvtps_pd(_mm_sub_ps(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)p)), _mm_set1_ps(x)));
+    }
+    inline void storeTruncated(int* p, Real v)    { _mm_storel_epi64((__m128i*)p, _mm_cvttpd_epi32(v)); }
+
+#else
+
+    const char* const NAME = "scalar";
+    const int WIDTH = 1;
+    typedef int Int;
+
+    inline Int  load(const int* p)        { return *p; }
+    inline Int  load(const int16_t* p)    { return *p; }
+    inline void store(int* p, Int v)      { *p = v; }
+    inline Int  splat(int x)              { return x; }
+    inline Int  lessThan(Int a, Int b)    { return -(a < b); }
+    inline Int  select(Int m, Int a, Int b) { return m ? a : b; }
+    inline Int  min(Int a, Int b)         { return a < b ? a : b; }
+    inline Int  max(Int a, Int b)         { return a > b ? a : b; }
+    inline Int  add(Int a, Int b)         { return a + b; }
+    inline Int  mul(Int a, Int b)         { return a * b; }
+
+    const int REAL_WIDTH = 1;
+    typedef double Real;
+
+    inline Real loadReal(const double* p)         { return *p; }
+    inline void storeReal(double* p, Real v)      { *p = v; }
+    inline Real splatReal(double x)               { return x; }
+    inline Real subReal(Real a, Real b)           { return a - b; }
+    inline Real addReal(Real a, Real b)           { return a + b; }
+    inline Real mulReal(Real a, Real b)           { return a * b; }
+    inline Real sqrtReal(Real a)                  { return sqrt(a); }
+    inline Real widenDiff(const float* p, float x) { return (double)(*p - x); }
+    inline void storeTruncated(int* p, Real v)    { *p = (int)v; }
+
+#endif
+
+}
+
+#endif
@@ -3,9 +3,12 @@
 
 #include <map>
 #include <vector>
+#include <string>
 #include <algorithm>
 #include "defs.h"
 #include "Utils.h"
+#include "FacilitySet.h"
+#include "Initializers.h"
 #include "ALNSFunction.h"
 #include "ALNSSolution.h"
 using namespace std;
@@ -32,12 +35,14 @@ struct FuncPair {
 class FacRandQDestroy : public ALNSFunction {
 public:
     FacRandQDestroy(int q) : ALNSFunction(q) {};
+    string getName() { return "FacRandQDestroy"; }
     ALNSSolution operator()(ALNSSolution solution) {
         this->timesUsed++;
 
         // destroy q facilities at random
-        for (int i = 0; i < this->numToChange; i++) {
-            int randNum = rand() % solution.facilities.size();
+        int q = this->numToChangeOf(solution.facilities.size());
+        for (int i = 0; i < q; i++) {
+            int randNum = this->rng->nextInt(solution.facilities.size());
             solution.facilities.erase(solution.facilities.begin() + randNum);
             solution.numUnassigned++;
         }
@@ -55,17 +60,14 @@ public:
 class FacWorstQDestroy : public ALNSFunction {
 public:
     FacWorstQDestroy(int q) : ALNSFunction(q) {};
+    string getName() { return "FacWorstQDestroy"; }
     ALNSSolution operator()(ALNSSolution solution) {
         this->timesUsed++;
-        solution.sortFacsByMeasures();
-
         // destroy q facilities with the worst fitness
         // facilities are sorted ascending, so worst are at the end
-        int length = solution.facilities.size() - 1;
-        for (int i = length; i > length - this->numToChange; i--) {
-            solution.facilities.erase(solution.facilities.begin() + i);
-            solution.numUnassigned++;
-        }
+        vector<int> sorted = solution.getFacsByMeasures();
+        int q = this->numToChangeOf(sorted.size());
+        solution.removeFacilities(vector<int>(sorted.end() - q, sorted.end()));
         return solution;
     }
 };
@@ -80,17 +82,14 @@ public:
 class FacBestQDestroy : public ALNSFunction {
 public:
     FacBestQDestroy(int q) : ALNSFunction(q) {};
+    string getName() { return "FacBestQDestroy"; }
     ALNSSolution operator()(ALNSSolution solution) {
         this->timesUsed++;
-        // get and sort appropriate measures (stars/radii) in descending order
-        solution.sortFacsByMeasures();
-
         // destroy q facilities with best fitness
         // we sorted in ascending order, so best fitness is at the beginning
-        for (int i = 0; i < this->numToChange; i++) {
-            solution.facilities.erase(solution.facilities.begin());
-            solution.numUnassigned++;
-        }
+        vector<int> sorted = solution.getFacsByMeasures();
+        int q = this->numToChangeOf(sorted.size());
+        solution.removeFacilities(vector<int>(sorted.begin(), sorted.begin() + q));
         return solution;
     }
 };
@@ -111,43 +110,90 @@ public:
  **/
 class FacRandRepair : public ALNSFunction {
 public:
+    string getName() { return "FacRandRepair"; }
     ALNSSolution operator()(ALNSSolution solution) {
         this->timesUsed++;
         int numUnassigned = solution.numUnassigned;
-        int possibleFacs  = solution.data.numCustomers;
+        FacilitySet& open = FacilitySet::forThread(solution.data.numCandidates);
+        open.assign(solution.facilities);
 
         // install necessary number of new facilities at random
         for (int i = 0; i < numUnassigned; i++) {
-            int fac;
-            vector<int>::iterator it;
-            do {
-                fac = rand() % possibleFacs;
-                it = find(solution.facilities.begin(), solution.facilities.end(), fac);
-            } while (it != solution.facilities.end());
+            int fac = open.randomClosed(*this->rng);
+            open.open(fac);
             solution.facilities.push_back(fac);
             solution.numUnassigned--;
         }
+        this->evaluations++;
         solution.update();
         return solution;
     }
 };
 
 /**
- * Allocates new facilities by performing a local search
+ * Allocates new facilities greedily: each one is the best of a sample of closed candidates (see Initializers::greedyExtend())
+ * Candidates are scored by the demand-weighted sum of nearest costs, against one array of nearest costs to the facilities
+ * that survived the destroy, so re-inserting q facilities is a single full evaluation (at the end) plus one pass per scored candidate
+ * instead of a full evaluation per candidate. Every scored candidate counts as an evaluation (see ALNS's PER_EVALUATION).
+ * Like the greedy initializers, it pulls toward the customers, so when maximizing it inserts at random instead
  * Assumes that the passed-in solution is NOT valid and needs to be repaired
  *
- * ???HOW ARE WE GOING TO DO A LOCAL SEARCH???
- *
  * @param ALNSSolution solution
  * @param ALNSSolution repairedSolution (i.e., with a few more entries in the facilities vector)
  **/
 class FacLSRepair : public ALNSFunction {
 public:
+    string getName() { return "FacLSRepair"; }
     ALNSSolution operator()(ALNSSolution solution) {
-        timesUsed++;
-        FacRandRepair rep = FacRandRepair();
-        return rep(solution);
+        const ProblemData& data = solution.data;
+        if (data.type.objective == MAXIMIZE) {
+            this->timesUsed++;
+            FacRandRepair rep = FacRandRepair();
+            rep.setRandom(this->rng);
+            solution = rep(solution);
+            this->evaluations += rep.getEvaluations();
+            return solution;
+        }
+
+        this->timesUsed++;
+        static thread_local vector<int> bestCosts, slots;
+        FacilitySet& open = FacilitySet::forThread(data.numCandidates);
+        open.assign(solution.facilities);
+        if (solution.facilities.empty()) {
+            bestCosts.assign(data.numCustomers, INT_MAX);
+        } else {
+            bestCosts.resize(data.numCustomers);
+            slots.resize(data.numCustomers);
+            data.nearest(solution.facilities, bestCosts.data(), slots.data());
+        }
+
+        this->evaluations += Initializers::greedyExtend(data, *this->rng, open, solution.facilities, bestCosts, solution.numUnassigned);
+        solution.numUnassigned = 0;
+        this->evaluations++;
+        solution.update();
+        return solution;
     }
 };
 
+/**
+ * Operator registry: builds a destroy/repair function from its getName(), so operators can be added by name at runtime
+ * (e.g. from JavaScript, which can't hand over C++ objects). New operators only need a line here.
+ *
+ * @param const string& name
+ * @param int q: number of facilities to destroy
+ * @return ALNSFunction* owned by the caller, or nullptr if there's no such operator
+ **/
+inline ALNSFunction* makeDestroyFunc(const string& name, int q) {
+    if (name == "FacRandQDestroy")  return new FacRandQDestroy(q);
+    if (name == "FacBestQDestroy")  return new FacBestQDestroy(q);
+    if (name == "FacWorstQDestroy") return new FacWorstQDestroy(q);
+    return nullptr;
+}
+
+inline ALNSFunction* makeRepairFunc(const string& name) {
+    if (name == "FacRandRepair") return new FacRandRepair();
+    if (name == "FacLSRepair")   return new FacLSRepair();
+    return nullptr;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Utils.h"
+#include "Random.h"
+#include "ProblemData.h"
+#include "FastInterchange.h"
+#include "IncrementalObjective.h"
+#include "Initializers.h"
+using namespace std;
+
+const int BENCH_REPEATS = 15;       // each time is the best of this many runs, which shrugs off a noisy machine
+const int BENCH_MOVES   = 200;
+const uint64_t BENCH_SEED = 42;
+
+long long sink = 0;                 // every result is folded in, so nothing is optimized away (printed at the end)
+
+// the fastest of BENCH_REPEATS runs, in milliseconds
+double bestTime(const function<void()>& run) {
+    double best = 0.0;
+    for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+        auto start = chrono::steady_clock::now();
+        run();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        best = (repeat == 0 ? ms : min(best, ms));
+    }
+    return best;
+}
+
+/**
+ * Times the incremental evaluation paths on one storage of a problem: IncrementalObjective::replace() (NDPSO's move),
+ * follow() after a destroy and repair (ALNS's), FastInterchange::bestSwap() over every candidate (VNS's), and greedy add
+ *
+ * @param const ProblemData& data
+ * @return void
+ **/
+void benchStorage(const ProblemData& data) {
+    int p = data.numFacilities;
+    Random rng (BENCH_SEED);
+    vector<int> facilities = Initializers::randomFacilities(data, rng, p);
+
+    IncrementalObjective state;
+    state.reset(data, facilities);
+    double replaceMs = bestTime([&] {
+        for (int move = 0; move < BENCH_MOVES; move++) {
+            int fac = rng.nextInt(data.numCandidates);
+            if (find(state.getFacilities().begin(), state.getFacilities().end(), fac) != state.getFacilities().end()) continue;
+            state.replace(data, rng.nextInt(p), fac);
+            sink += state.getObjective();
+        }
+    });
+
+    vector<int> current = state.getFacilities();
+    double followMs = bestTime([&] {
+        for (int move = 0; move < BENCH_MOVES; move++) {
+            for (int i = 0; i < 3; i++) current.erase(current.begin() + rng.nextInt(current.size()));
+            while ((int) current.size() < p) {
+                int fac = rng.nextInt(data.numCandidates);
+                if (find(current.begin(), current.end(), fac) == current.end()) current.push_back(fac);
+            }
+            state.follow(data, current);
+            sink += state.getObjective();
+        }
+    });
+
+    FastInterchange interchange;
+    interchange.reset(data, facilities);
+    double swapMs = bestTime([&] {
+        for (int fac = 0; fac < data.numCandidates; fac++) {
+            int slot;
+            sink += interchange.bestSwap(data, fac, slot);
+        }
+    });
+
+    double greedyMs = bestTime([&] { sink += Initializers::greedyAdd(data, rng, p)[0]; });
+
+    cout << "  " << (data.isCompact() ? "16-bit" : "32-bit") << ": replace " << replaceMs << " ms, follow " << followMs
+         << " ms, bestSwap " << swapMs << " ms, greedyAdd " << greedyMs << " ms" << endl;
+}
+
+/**
+ * Native timings of the incremental evaluation paths on 16-bit (compact) and 32-bit cost storage. Built and run by `make bench`.
+ *
+ * usage: bench <instance files...>
+ **/
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        cout << "usage: bench <instance files...>" << endl;
+        return 1;
+    }
+    for (int i = 1; i < argc; i++) {
+        try {
+            ProblemData data = Utils::getData(argv[i]);
+            cout << data.name << " (n = " << data.numCustomers << ", p = " << data.numFacilities << "):" << endl;
+            ProblemData wide = data;
+            wide.widen();
+            benchStorage(wide);
+            if (data.isCompact()) benchStorage(data);
+        } catch (const char* e) {
+            cout << argv[i] << ": " << e << endl;
+            return 1;
+        }
+    }
+    cout << "checksum " << sink << endl;
+    return 0;
+}
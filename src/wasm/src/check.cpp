@@ -0,0 +1,217 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ProblemData.h"
+#include "ALNSSolution.h"
+#include "alns-functions.h"
+#include "Random.h"
+#include "Comparator.h"
+#include "IncrementalObjective.h"
+using namespace std;
+
+const int CHECK_CUSTOMERS  = 400;
+const int CHECK_FACILITIES = 60;    // above INCREMENTAL_MIN_FACILITIES, so ALNSSolution::update() follows rather than evaluates
+const int CHECK_MOVES      = 200;
+
+/**
+ * A random square problem of the given type, costs in [1, maxCost] and demand in [1, maxDemand]
+ *
+ * @param Random& rng
+ * @param ProblemType type
+ * @param int maxCost
+ * @param int maxDemand
+ * @return ProblemData
+ **/
+ProblemData randomProblem(Random& rng, ProblemType type, int maxCost, int maxDemand) {
+    ProblemData data;
+    data.allocate(CHECK_CUSTOMERS);
+    data.name = "random";
+    data.type = type;
+    data.numFacilities = CHECK_FACILITIES;
+    for (int fac = 0; fac < CHECK_CUSTOMERS; fac++) {
+        for (int cust = 0; cust < CHECK_CUSTOMERS; cust++) {
+            data.setCost(cust, fac, (cust == fac ? 0 : 1 + rng.nextInt(maxCost)));
+        }
+    }
+    for (int cust = 0; cust < CHECK_CUSTOMERS; cust++) {
+        (*data.demand)[cust] = 1 + rng.nextInt(maxDemand);
+    }
+    return data;
+}
+
+// a copy of the problem with the given storage: "32-bit", "16-bit" or "implicit" (costs from coordinates, which ignores data's)
+ProblemData withStorage(const ProblemData& data, const string& storage, Random& rng) {
+    ProblemData copy = data;
+    if (storage == "implicit") {
+        copy.allocateCoordinates(data.numCustomers);
+        for (int i = 0; i < data.numCustomers; i++) {
+            copy.coordinates->x[i] = rng.nextInt(100);      // a coarse grid, so there are plenty of ties
+            copy.coordinates->y[i] = rng.nextInt(100);
+        }
+        copy.setMetric(PLANAR);
+        copy.demand = data.demand;
+    } else {
+        copy.costs = make_shared<vector<int>>(*data.costs);
+        if (storage == "16-bit" && !copy.compact()) throw "check: costs don't fit in 16 bits!";
+    }
+    return copy;
+}
+
+// a closed candidate, drawn at random
+int closedFacility(const ProblemData& data, const vector<int>& facilities, Random& rng) {
+    int fac;
+    do {
+        fac = rng.nextInt(data.numCandidates);
+    } while (find(facilities.begin(), facilities.end(), fac) != facilities.end());
+    return fac;
+}
+
+/**
+ * Compares one state against a full evaluation of its facilities: the objective, the assignments,
+ * and evaluateBounded() both without a cutoff and with one drawn around the objective
+ * (no worse than the cutoff means exact; worse than it only has to be a bound that's still worse and no better than the objective)
+ *
+ * @param const ProblemData& data
+ * @param const IncrementalObjective& state
+ * @param Random& rng
+ * @return bool whether everything agreed
+ **/
+bool agrees(const ProblemData& data, const IncrementalObjective& state, Random& rng) {
+    vector<int> expected, assignments;
+    int objective = data.evaluate(state.getFacilities(), &expected);
+    state.getAssignments(assignments);
+    if (state.getObjective() != objective || assignments != expected) return false;
+    if (data.evaluateBounded(state.getFacilities(), INT_MAX) != objective) return false;
+
+    int cutoff = (int) max((long long) INT_MIN, min((long long) INT_MAX, objective + (long long) rng.nextInt(2001) - 1000));
+    int bounded = data.evaluateBounded(state.getFacilities(), cutoff);
+    Comparator comparator (data.type.objective);
+    if (!comparator(cutoff, bounded)) return bounded == objective;
+    return !comparator(objective, bounded);
+}
+
+/**
+ * Drives IncrementalObjective through a random sequence of moves (replace(), remove(), add(), and follow() after edits like
+ * ALNS's, reordered now and then so it has to start over) and checks every state against ProblemData::evaluate()
+ *
+ * @param const ProblemData& data
+ * @param Random& rng
+ * @return int number of states that disagreed
+ **/
+int checkMoves(const ProblemData& data, Random& rng) {
+    vector<int> facilities;
+    for (int i = 0; i < data.numFacilities; i++) facilities.push_back(closedFacility(data, facilities, rng));
+    IncrementalObjective state;
+    state.reset(data, facilities);
+
+    int wrong = (agrees(data, state, rng) ? 0 : 1);
+    for (int move = 0; move < CHECK_MOVES; move++) {
+        vector<int> current = state.getFacilities();
+        int p = current.size();
+        switch (rng.nextInt(4)) {
+            case 0:
+                state.replace(data, rng.nextInt(p), closedFacility(data, current, rng));
+                break;
+            case 1: {
+                // erase a few slots, then put as many facilities back one at a time
+                vector<int> removed;
+                for (int slot = 0; slot < p; slot++) {
+                    if (rng.nextInt(p) < 3) removed.push_back(slot);
+                }
+                state.remove(data, removed);
+                while ((int) state.getFacilities().size() < p) state.add(data, closedFacility(data, state.getFacilities(), rng));
+                break;
+            }
+            default: {
+                int destroyed = 1 + rng.nextInt(5);
+                for (int i = 0; i < destroyed; i++) current.erase(current.begin() + rng.nextInt(current.size()));
+                if (rng.nextInt(8) == 0) swap(current.front(), current.back());
+                while ((int) current.size() < p) current.push_back(closedFacility(data, current, rng));
+                state.follow(data, current);
+                break;
+            }
+        }
+        if (!agrees(data, state, rng)) wrong++;
+    }
+    return wrong;
+}
+
+/**
+ * Runs each destroy operator against FacRandRepair and counts the repairs whose update() started over with a full evaluation:
+ * a destroy that keeps the surviving facilities in order should leave every one of them to IncrementalObjective::follow()
+ *
+ * @param const ProblemData& data
+ * @param Random& rng
+ * @return int number of failures
+ **/
+int checkFollowResets(const ProblemData& data, Random& rng) {
+    int failures = 0;
+    vector<ALNSFunction*> destroys = { new FacRandQDestroy(3), new FacWorstQDestroy(3), new FacBestQDestroy(3) };
+    FacRandRepair repair;
+    repair.setRandom(&rng);
+    for (ALNSFunction* destroy : destroys) {
+        destroy->setRandom(&rng);
+        vector<int> facilities;
+        for (int fac = 0; fac < data.numFacilities; fac++) facilities.push_back(fac);
+        ALNSSolution solution (data, 0, facilities, {}, 0);
+        solution.update();
+
+        long long before = solution.state.getResets();
+        int wrong = 0;
+        for (int move = 0; move < CHECK_MOVES; move++) {
+            solution = repair((*destroy)(solution));
+            if (solution.objective != data.evaluate(solution.facilities)) wrong++;
+        }
+        long long resets = solution.state.getResets() - before;
+        cout << "  " << destroy->getName() << ": " << resets << " resets in " << CHECK_MOVES << " moves" << (wrong > 0 ? ", " + to_string(wrong) + " wrong objectives" : "") << endl;
+        if (resets > 0 || wrong > 0) failures++;
+        delete destroy;
+    }
+    return failures;
+}
+
+/**
+ * Native consistency checks of the incremental evaluation paths against ProblemData::evaluate(). Built and run by `make check`.
+ *
+ * usage: check
+ **/
+int main() {
+    Random rng (1);
+    int failures = 0;
+    try {
+        ProblemData data = randomProblem(rng, { MINIMIZE, SUM, STAR }, 1000, 100);
+        cout << "follow() after each destroy operator:" << endl;
+        failures += checkFollowResets(data, rng);
+
+        // few distinct costs make plenty of ties; big costs times big demand overflow an int, so the stars saturate
+        cout << "IncrementalObjective and evaluateBounded() against evaluate(), " << CHECK_MOVES << " moves each:" << endl;
+        vector<pair<int, int>> scales = { { 20, 5 }, { 30000, 100000 } };
+        for (auto scale : scales) {
+            for (string storage : { "32-bit", "16-bit", "implicit" }) {
+                int wrong = 0, types = 0;
+                for (int objective = MAXIMIZE; objective <= MINIMIZE; objective++) {
+                    for (int aggregate = MAX; aggregate <= SUM; aggregate++) {
+                        for (int measure = STAR; measure <= RAY; measure++) {
+                            ProblemType type = { (Objective) objective, (Aggregate) aggregate, (Measure) measure };
+                            ProblemData problem = withStorage(randomProblem(rng, type, scale.first, scale.second), storage, rng);
+                            int disagreed = checkMoves(problem, rng);
+                            if (disagreed > 0) {
+                                cout << "    type " << objective << aggregate << measure << ": " << disagreed << " states disagreed" << endl;
+                                wrong++;
+                            }
+                            types++;
+                        }
+                    }
+                }
+                cout << "  costs up to " << scale.first << ", demand up to " << scale.second << ", " << storage << ": "
+                     << types - wrong << "/" << types << " problem types agree" << endl;
+                failures += wrong;
+            }
+        }
+    } catch (const char* e) {
+        cout << e << endl;
+        return 1;
+    }
+    cout << (failures == 0 ? "all checks passed" : to_string(failures) + " checks failed") << endl;
+    return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,45 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Utils.h"
+using namespace std;
+
+/**
+ * Packs instance files into one bundle of precomputed, compressed instances plus a JSON index
+ * so the browser can fetch a single instance on demand instead of preloading every text file
+ * (see src/js/loadInstance.js). Built and run by `make bundle`.
+ *
+ * usage: pack <bundle.bin> <index.json> <instance files...>
+ **/
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        cout << "usage: pack <bundle.bin> <index.json> <instance files...>" << endl;
+        return 1;
+    }
+    ofstream bundle (argv[1], ios::binary);
+    ofstream index (argv[2]);
+
+    size_t offset = 0;
+    index << "{\"version\": 1, \"instances\": {";
+    for (int i = 3; i < argc; i++) {
+        try {
+            ProblemData data = Utils::getData(argv[i]);
+            string bytes = Utils::encodeInstance(data);
+            bundle.write(bytes.data(), bytes.size());
+
+            string key = data.name.substr(0, data.name.find('.'));
+            index << (i > 3 ? ",\n  " : "\n  ");
+            index << "\"" << key << "\": {\"offset\": " << offset << ", \"length\": " << bytes.size()
+                  << ", \"numCustomers\": " << data.numCustomers << ", \"numCandidates\": " << data.numCandidates << ", \"numFacilities\": " << data.numFacilities << "}";
+            offset += bytes.size();
+            cout << key << ": " << bytes.size() << " bytes" << endl;
+        } catch (const char* e) {
+            cout << argv[i] << ": " << e << endl;
+            return 1;
+        }
+    }
+    index << "\n}}\n";
+    cout << "bundle: " << offset << " bytes" << endl;
+    return 0;
+}
@@ -1,12 +1,20 @@
 #include "../include/defs.h"
 #include "../include/Algorithm.h"
 #include "../include/ProblemData.h"
+#include "../include/ProblemDelta.h"
 #include "../include/ProblemResults.h"
 // Even though I never directly reference Particle,
 // the EMSDK wants it explicitly bound or else it throws a fit during runtime
 #include "../include/Particle.cpp"
 #include "../include/Listener.h"
 #include "../include/NDPSO.cpp"
+#include "../include/ALNS.cpp"
+#include "../include/ALNSSolution.cpp"
+#include "../include/MultiStartALNS.cpp"
+#include "../include/IslandNDPSO.cpp"
+#include "../include/VNS.cpp"
+#include "../include/RoadNetwork.cpp"
+#include "../include/ThreadPool.h"
 #include "../include/Utils.cpp"
 #include <vector>
 #include <emscripten.h>
@@ -34,28 +42,181 @@ public:
     void handleParticle(Particle* particle, int iteration) {
         return call<void>("handle", std::string("particle"), particle, iteration);
     }
+
+    // the view aliases the algorithm's last checkpoint; copy it (.slice()) before handing it anywhere
+    void handleCheckpoint(const std::string& checkpoint, int iteration) {
+        return call<void>("handle", std::string("checkpoint"), val(typed_memory_view(checkpoint.size(), (const uint8_t*)checkpoint.data())), iteration);
+    }
 };
 
 /* 
 
-build command (until I get the EMSDK in the Docker container and thus can add an entry to the makefile; run from Default directory):
+build commands live in build/Makefile (run from the build directory with the EMSDK on the path):
 
-emcc --bind -s WASM=1 -s ALLOW_MEMORY_GROWTH=1 -s ASSERTIONS=1 -O3 --std=c++11 --preload-file ../problems -o cdflm.js ../src/wasm.cpp
+make wasm           single-threaded module (cdflm.js)
+make wasm-mt        pthreads module (cdflm-mt.js); needs SharedArrayBuffer, i.e. a cross-origin isolated page or Node
+make wasm-simd      SIMD128 evaluation kernels (cdflm-simd.js); needs an engine with WebAssembly SIMD
+make wasm-mt-simd   both (cdflm-mt-simd.js)
+
+src/js/loadCDFLM.js picks the best of these the engine supports at load time. Call setNumThreads() once after loading the pthreads build;
+NDPSO then evaluates its swarm in parallel, MultiStartALNS runs one ALNS per thread and IslandNDPSO one island per thread.
+The pthreads build must be driven from a Worker in the browser, since the main thread isn't allowed to block.
 
 */
 
-ProblemData getORLIBData(int num) {
-    return Utils::getData("../problems/ORLIB/pmed" + to_string(num) + ".txt");
+/**
+ * Builds a problem from one instance of the precomputed bundle (see src/pack.cpp and src/js/loadInstance.js)
+ * JS passes the instance's bytes as a Uint8Array
+ *
+ * @param string bytes
+ * @return ProblemData
+ **/
+ProblemData loadInstance(std::string bytes) {
+    return Utils::decodeInstance(bytes);
+}
+
+/*
+
+ProblemData and ProblemResults are bound as classes, so JS holds handles to objects that live in WASM memory
+instead of getting element-by-element copies of their matrices. The views below are typed arrays that alias
+the underlying buffers directly:
+
+    const problem = new Module.ProblemData();
+    problem.numFacilities = 5;
+    problem.allocate(n);
+    problem.getCostsView().set(costs);  // costs: Int32Array, facility-major (costs[fac * n + cust])
+                                        // or allocateRectangular(n, m) for m candidate sites, with m rows of n costs
+                                        // or allocateCoordinates(n) and fill getXView()/getYView() for O(n) implicit costs
+                                        // (then setMetric(Module.Metric.HAVERSINE) for km, and/or materialize() for a matrix)
+    problem.compact();                  // optional: 16-bit costs if they all fit (getCostsView() is then an Int16Array);
+                                        // the problem gets a buffer of its own, no longer shared with the copies it came from
+    const results = ndpso.optimize(problem);
+    const facilities = results.getFacilitiesView().slice();
+    results.delete();
+
+A view is invalidated whenever WASM memory grows (ALLOW_MEMORY_GROWTH), so fetch a fresh one after anything that allocates
+instead of holding on to it. Copies of a ProblemData share its buffers, so the same handle can be solved repeatedly for free.
+
+Every algorithm (NDPSO, ALNS, VNS, ...) can also be driven a slice at a time, so a page or a worker never blocks on a whole solve:
+
+    const alns = new Module.ALNS();
+    alns.init(problem);
+    function tick() {
+        alns.stepFor(8);                 // ~8ms of search, then hand control back
+        render(alns.best());             // (best() returns a handle; delete it when done)
+        if (!alns.isDone()) requestAnimationFrame(tick);
+    }
+    tick();                              // alns.cancel() stops it at the next iteration
+
+A search can be saved and picked up again later, even in another process, and it continues exactly where it left off:
+
+    alns.setCheckpointInterval(1000);    // listener.handle('checkpoint', view, iteration) every 1000 iterations
+    const saved = alns.checkpoint().slice();
+    ...
+    const alns = new Module.ALNS();
+    alns.resume(problem, saved);         // instead of init(); then step()/stepFor() as usual
+
+ALNS's destroy/repair operators can be swapped out by name before init() (a checkpoint needs the same set, in the same order):
+
+    alns.clearFuncs();
+    alns.addDestroyFunc('FacRandQDestroy', 2);      // destroys 2 facilities at random
+    alns.addScaledDestroyFunc('FacWorstQDestroy', 0.1);    // destroys 10% of p, however large p is
+    alns.addRepairFunc('FacLSRepair');              // greedy re-insertion
+    alns.setWeightScheme(Module.WeightScheme.PER_MILLISECOND);  // fitness = reward per millisecond, not per use
+    alns.getJSONFuncs();                            // the operators, their fitnesses and what they've done so far
+
+When the network changes a little, re-solve from the last answer instead of from scratch:
+
+    const delta = new Module.ProblemDelta();
+    delta.changeCost(cust, fac, cost);   // plus removeNode(node), addNode(costsToEveryNode), numFacilities = p
+    const next = alns.reoptimize(problem, results, delta, 200);   // updates problem in place, then searches; ~200ms in all
+
+For a road network, let a RoadNetwork keep the shortest paths current edge by edge and hand over what changed:
+
+    const network = new Module.RoadNetwork(numNodes);
+    edges.forEach(([a, b, w]) => network.addEdge(a, b, w));
+    network.computeAllPairs();
+    const problem = network.getData();   // shares the network's costs; set problem.numFacilities
+                                         // (but don't compact() it: that gives it its own buffer, and only the
+                                         // deltas passed to reoptimize() would reach it from then on)
+    network.setEdge(a, b, w);            // or removeEdge(a, b); only the affected pairs are recomputed
+    const next = alns.reoptimize(problem, results, network.takeDelta(), 200);
+
+*/
+
+void setNumThreads(int numThreads) {
+    ThreadPool::getInstance().setNumThreads(numThreads);
+}
+
+int getNumThreads() {
+    return ThreadPool::getInstance().getNumThreads();
+}
+
+string getKernelName() {
+    return VecOps::NAME;
+}
+
+// implicit problems have no matrix, and nothing has one before allocate(), so this returns null for them
+// a compact problem's costs come back as an Int16Array (see ProblemData::compact())
+val getCostsView(ProblemData& data) {
+    if (data.isImplicit()) return val::null();
+    if (data.isCompact()) return val(typed_memory_view(data.narrowCosts->size(), data.narrowCosts->data()));
+    if (!data.costs) return val::null();
+    return val(typed_memory_view(data.costs->size(), data.costs->data()));
+}
+
+// one weight per customer (every allocated problem has these; null before that)
+val getDemandView(ProblemData& data) {
+    if (!data.demand) return val::null();
+    return val(typed_memory_view(data.demand->size(), data.demand->data()));
+}
+
+// x (lng) and y (lat) of every node of an implicit problem; null for a matrix problem
+val getXView(ProblemData& data) {
+    if (!data.isImplicit()) return val::null();
+    return val(typed_memory_view(data.coordinates->x.size(), data.coordinates->x.data()));
+}
+
+val getYView(ProblemData& data) {
+    if (!data.isImplicit()) return val::null();
+    return val(typed_memory_view(data.coordinates->y.size(), data.coordinates->y.data()));
+}
+
+val getFacilitiesView(ProblemResults& results) {
+    return val(typed_memory_view(results.facilities.size(), results.facilities.data()));
+}
+
+val getCustomersView(ProblemResults& results) {
+    return val(typed_memory_view(results.customerAssignments.size(), results.customerAssignments.data()));
+}
+
+// takes a fresh checkpoint and returns a view of it (valid until the next call, so slice() it)
+val checkpoint(Algorithm& alg) {
+    static string bytes;
+    bytes = alg.checkpoint();
+    return val(typed_memory_view(bytes.size(), (const uint8_t*)bytes.data()));
+}
+
+val getLastCheckpointView(Algorithm& alg) {
+    const string& bytes = alg.getLastCheckpoint();
+    return val(typed_memory_view(bytes.size(), (const uint8_t*)bytes.data()));
+}
+
+void resume(Algorithm& alg, ProblemData data, std::string checkpoint) {
+    alg.resume(data, checkpoint);
+}
+
+void warmStart(Algorithm& alg, ProblemData data, val facilities) {
+    alg.warmStart(data, vecFromJSArray<int>(facilities));
 }
 
-ProblemData getDaskinData() {
-    return Utils::getData("../problems/Daskin/city1990.grt");
+void addNode(ProblemDelta& delta, val costs) {
+    delta.addNode(vecFromJSArray<int>(costs));
 }
 
 EMSCRIPTEN_BINDINGS(cdflm_cpp) {
     register_vector<Particle>("VectorParticle");
     register_vector<int>("VectorInt");
-    register_vector<vector<int>>("VectorVectorInt");
 
     enum_<Objective>("Objective")
         .value("MAXIMIZE", MAXIMIZE)
@@ -71,28 +232,87 @@ EMSCRIPTEN_BINDINGS(cdflm_cpp) {
         .value("RADIUS", RADIUS)
         .value("RAY", RAY);
 
+    enum_<InitStrategy>("InitStrategy")
+        .value("AUTO_INIT", AUTO_INIT)
+        .value("GREEDY_ADD", GREEDY_ADD)
+        .value("GREEDY_DROP", GREEDY_DROP)
+        .value("KMEANS_PLUS_PLUS", KMEANS_PLUS_PLUS)
+        .value("FARTHEST_POINT", FARTHEST_POINT)
+        .value("RANDOM_INIT", RANDOM_INIT)
+        .value("SWARM_INIT", SWARM_INIT);
+
+    enum_<WeightScheme>("WeightScheme")
+        .value("PER_USE", PER_USE)
+        .value("PER_MILLISECOND", PER_MILLISECOND)
+        .value("PER_EVALUATION", PER_EVALUATION);
+
+    enum_<Topology>("Topology")
+        .value("RING", RING)
+        .value("RANDOM_DESTINATION", RANDOM_DESTINATION);
+
+    enum_<Metric>("Metric")
+        .value("PLANAR", PLANAR)
+        .value("HAVERSINE", HAVERSINE);
+
     value_object<ProblemType>("ProblemType")
         .field("objective", &ProblemType::objective)
         .field("aggregate", &ProblemType::aggregate)
         .field("measure", &ProblemType::measure);
 
-    value_object<ProblemData>("ProblemData")
-        .field("name", &ProblemData::name)
-        .field("type", &ProblemData::type)
-        .field("numFacilities", &ProblemData::numFacilities)
-        .field("numCustomers", &ProblemData::numCustomers)
-        .field("costs", &ProblemData::costs)
-        .field("demand", &ProblemData::demand);
+    class_<ProblemData>("ProblemData")
+        .constructor<>()
+        .property("name", &ProblemData::name)
+        .property("type", &ProblemData::type)
+        .property("numFacilities", &ProblemData::numFacilities)
+        .property("numCustomers", &ProblemData::numCustomers)
+        .property("numCandidates", &ProblemData::numCandidates)
+        .function("allocate", select_overload<void(int)>(&ProblemData::allocate))
+        .function("allocateRectangular", select_overload<void(int, int)>(&ProblemData::allocate))
+        .function("isSquare", &ProblemData::isSquare)
+        .function("allocateCoordinates", &ProblemData::allocateCoordinates)
+        .function("isImplicit", &ProblemData::isImplicit)
+        .function("setMetric", &ProblemData::setMetric)
+        .function("materialize", &ProblemData::materialize)
+        .function("compact", &ProblemData::compact)
+        .function("widen", &ProblemData::widen)
+        .function("isCompact", &ProblemData::isCompact)
+        .function("getCostsView", &getCostsView)
+        .function("getDemandView", &getDemandView)
+        .function("getXView", &getXView)
+        .function("getYView", &getYView);
+
+    class_<ProblemDelta>("ProblemDelta")
+        .constructor<>()
+        .property("numFacilities", &ProblemDelta::numFacilities)
+        .function("removeNode", &ProblemDelta::removeNode)
+        .function("addNode", &addNode)
+        .function("changeCost", &ProblemDelta::changeCost);
+
+    class_<RoadNetwork>("RoadNetwork")
+        .constructor<int>()
+        .function("addEdge", &RoadNetwork::addEdge)
+        .function("computeAllPairs", &RoadNetwork::computeAllPairs)
+        .function("setEdge", &RoadNetwork::setEdge)
+        .function("removeEdge", &RoadNetwork::removeEdge)
+        .function("getEdge", &RoadNetwork::getEdge)
+        .function("getNumEdges", &RoadNetwork::getNumEdges)
+        .function("getData", &RoadNetwork::getData)
+        .function("getAffectedCustomers", &RoadNetwork::getAffectedCustomers)
+        .function("takeDelta", &RoadNetwork::takeDelta);
 
-    value_object<ProblemResults>("ProblemResults")
-        .field("time", &ProblemResults::time)
-        .field("objective", &ProblemResults::objective)
-        .field("facilities", &ProblemResults::facilities)
-        .field("customerAssignments", &ProblemResults::customerAssignments)
-        .field("type", &ProblemResults::type);
+    class_<ProblemResults>("ProblemResults")
+        .property("time", &ProblemResults::time)
+        .property("objective", &ProblemResults::objective)
+        .property("type", &ProblemResults::type)
+        .function("getFacilitiesView", &getFacilitiesView)
+        .function("getCustomersView", &getCustomersView)
+        .function("getJSONFacilities", &ProblemResults::getJSONFacilities)
+        .function("getJSONCustomers", &ProblemResults::getJSONCustomers);
 
-    emscripten::function("getORLIBData", &getORLIBData);
-    emscripten::function("getDaskinData", &getDaskinData);
+    emscripten::function("loadInstance", &loadInstance);
+    emscripten::function("setNumThreads", &setNumThreads);
+    emscripten::function("getNumThreads", &getNumThreads);
+    emscripten::function("getKernelName", &getKernelName);
 
     class_<Listener>("Listener")
         .function("handleAlgorithm", &Listener::handleAlgorithm, pure_virtual(), allow_raw_pointers())
@@ -101,13 +321,74 @@ EMSCRIPTEN_BINDINGS(cdflm_cpp) {
         .allow_subclass<ListenerWrapper>("ListenerWrapper");
 
     class_<Algorithm>("Algorithm")
-        .function("setListener", &Algorithm::setListener, allow_raw_pointers());
+        .function("setListener", &Algorithm::setListener, allow_raw_pointers())
+        .function("optimize", &Algorithm::optimize)
+        .function("init", &Algorithm::init)
+        .function("step", &Algorithm::step)
+        .function("stepFor", &Algorithm::stepFor)
+        .function("best", &Algorithm::best)
+        .function("cancel", &Algorithm::cancel)
+        .function("isDone", &Algorithm::isDone)
+        .function("getIteration", &Algorithm::getIteration)
+        .function("getMaxIterations", &Algorithm::getMaxIterations)
+        .function("setMaxIterations", &Algorithm::setMaxIterations)
+        .function("checkpoint", &checkpoint)
+        .function("getLastCheckpointView", &getLastCheckpointView)
+        .function("resume", &resume)
+        .function("warmStart", &warmStart)
+        .function("reoptimize", &Algorithm::reoptimize)
+        .function("setCheckpointInterval", &Algorithm::setCheckpointInterval)
+        .function("getCheckpointInterval", &Algorithm::getCheckpointInterval)
+        .function("getJSONBoundStats", &Algorithm::getJSONBoundStats)
+        .function("setSeed", optional_override([](Algorithm& alg, double seed) { alg.setSeed((uint64_t)seed); }));
 
     class_<Particle>("Particle");
 
     class_<NDPSO, base<Algorithm>>("NDPSO")
         .constructor<>()
-        .function("optimize", &NDPSO::optimize)
+        .constructor<int>()
         .function("getName", &NDPSO::getName)
-        .function("getJSONParameters", &NDPSO::getJSONParameters);
+        .function("getJSONParameters", &NDPSO::getJSONParameters)
+        .function("getJSONCacheStats", &NDPSO::getJSONCacheStats);
+
+    class_<ALNS, base<Algorithm>>("ALNS")
+        .constructor<>()
+        .function("getName", &ALNS::getName)
+        .function("getJSONParameters", &ALNS::getJSONParameters)
+        .function("addDestroyFunc", select_overload<void(const string&, int)>(&ALNS::addDestroyFunc))
+        .function("addRepairFunc", select_overload<void(const string&)>(&ALNS::addRepairFunc))
+        .function("addScaledDestroyFunc", &ALNS::addScaledDestroyFunc)
+        .function("clearFuncs", &ALNS::clearFuncs)
+        .function("getJSONFuncs", &ALNS::getJSONFuncs)
+        .function("setWeightScheme", &ALNS::setWeightScheme)
+        .function("getWeightScheme", &ALNS::getWeightScheme)
+        .function("setInitStrategy", &ALNS::setInitStrategy)
+        .function("getInitStrategy", &ALNS::getInitStrategy);
+
+    class_<VNS, base<Algorithm>>("VNS")
+        .constructor<>()
+        .constructor<int>()
+        .function("getName", &VNS::getName)
+        .function("getJSONParameters", &VNS::getJSONParameters)
+        .function("setKMax", &VNS::setKMax)
+        .function("getKMax", &VNS::getKMax);
+
+    class_<MultiStartALNS, base<Algorithm>>("MultiStartALNS")
+        .constructor<>()
+        .constructor<int>()
+        .function("getName", &MultiStartALNS::getName)
+        .function("getJSONParameters", &MultiStartALNS::getJSONParameters)
+        .function("getNumStarts", &MultiStartALNS::getNumStarts);
+
+    class_<IslandNDPSO, base<Algorithm>>("IslandNDPSO")
+        .constructor<>()
+        .constructor<int>()
+        .constructor<int, int, int, Topology>()
+        .function("getName", &IslandNDPSO::getName)
+        .function("getJSONParameters", &IslandNDPSO::getJSONParameters)
+        .function("getJSONConvergence", &IslandNDPSO::getJSONConvergence)
+        .function("getNumIslands", &IslandNDPSO::getNumIslands)
+        .function("setMigrationInterval", &IslandNDPSO::setMigrationInterval)
+        .function("setNumMigrants", &IslandNDPSO::setNumMigrants)
+        .function("setTopology", &IslandNDPSO::setTopology);
 }
\ No newline at end of file